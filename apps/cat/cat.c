@@ -0,0 +1,66 @@
+/*
+ * cat.c - Concatenate files to standard output for IPO_OS
+ *
+ * With no arguments, copies standard input to standard output, which
+ * makes it the usual last stage of a pipeline ("hello a b | cat > /out").
+ *
+ * Usage: cat [file...]
+ */
+
+#include <syscall.h>
+
+#define CHUNK_SIZE 4096
+
+/**
+ * copy_stdin - Copies standard input until end of file
+ */
+static int copy_stdin(void) {
+    char buf[CHUNK_SIZE];
+    int n;
+    while ((n = sys_stdin_read(buf, sizeof(buf))) > 0) {
+        sys_console_write(buf, (uint32_t)n);
+    }
+    return n < 0 ? 1 : 0;
+}
+
+/**
+ * copy_file - Copies one file to standard output
+ */
+static int copy_file(const char *path) {
+    int fd = sys_open(path);
+    if (fd < 0) {
+        sys_print("cat: cannot open ");
+        sys_print(path);
+        sys_print("\n");
+        return 1;
+    }
+
+    char buf[CHUNK_SIZE];
+    uint32_t offset = 0;
+    int n;
+    while ((n = sys_read(fd, buf, sizeof(buf), offset)) > 0) {
+        sys_console_write(buf, (uint32_t)n);
+        offset += (uint32_t)n;
+    }
+
+    sys_close(fd);
+    return n < 0 ? 1 : 0;
+}
+
+/**
+ * main - Application entry point
+ *
+ * @argc: Number of command-line arguments
+ * @argv: Array of command-line argument strings
+ */
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        return copy_stdin();
+    }
+
+    int status = 0;
+    for (int i = 1; i < argc; i++) {
+        status |= copy_file(argv[i]);
+    }
+    return status;
+}
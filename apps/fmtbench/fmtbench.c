@@ -0,0 +1,139 @@
+/*
+ * fmtbench.c - Integer formatting benchmark for IPO_OS
+ *
+ * Times the library's itoa/itoa64 against the previous digit-by-digit
+ * division loops (kept here as the reference) for 32-bit and 64-bit
+ * decimal and hex values, and checks that both produce the same text.
+ *
+ * Usage: fmtbench [iterations]
+ */
+
+#include <syscall.h>
+#include <stdio.h>
+#include <string.h>
+
+#define DEFAULT_ITERATIONS 20000
+
+static inline uint64_t rdtsc(void) {
+    uint32_t lo, hi;
+    __asm__ volatile ("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+static uint32_t parse_uint(const char *s) {
+    uint32_t v = 0;
+    while (*s >= '0' && *s <= '9') {
+        v = v * 10 + (uint32_t)(*s++ - '0');
+    }
+    return v;
+}
+
+/* Reference: one 64-bit division (a libgcc call) per digit */
+static int old_itoa64(uint64_t num, char *str, int base) {
+    char digits[64];
+    int i = 0, len = 0;
+    do {
+        uint64_t d = num % base;
+        digits[i++] = (char)(d < 10 ? '0' + d : 'a' + (d - 10));
+        num /= base;
+    } while (num > 0 && i < 63);
+    while (i > 0) str[len++] = digits[--i];
+    str[len] = '\0';
+    return len;
+}
+
+/* Reference: one 32-bit division per digit */
+static int old_itoa(unsigned int num, char *str, int base) {
+    char digits[32];
+    int i = 0, len = 0;
+    do {
+        unsigned int d = num % base;
+        digits[i++] = (char)(d < 10 ? '0' + d : 'a' + (d - 10));
+        num /= base;
+    } while (num > 0 && i < 32);
+    while (i > 0) str[len++] = digits[--i];
+    str[len] = '\0';
+    return len;
+}
+
+/* xorshift64: spreads values over all digit counts */
+static uint64_t next_value(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x >> (x & 63);
+}
+
+/* A flag rather than function pointers: the app has no GOT to resolve them */
+static uint64_t time32(int use_new, int base, uint32_t iterations) {
+    char buf[72];
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+    uint64_t start = rdtsc();
+    for (uint32_t i = 0; i < iterations; i++) {
+        unsigned int v = (unsigned int)next_value(&state);
+        if (use_new) itoa(v, buf, base);
+        else old_itoa(v, buf, base);
+    }
+    return rdtsc() - start;
+}
+
+static uint64_t time64(int use_new, int base, uint32_t iterations) {
+    char buf[72];
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+    uint64_t start = rdtsc();
+    for (uint32_t i = 0; i < iterations; i++) {
+        uint64_t v = next_value(&state);
+        if (use_new) itoa64(v, buf, base);
+        else old_itoa64(v, buf, base);
+    }
+    return rdtsc() - start;
+}
+
+static void report(const char *name, uint64_t old_cycles, uint64_t new_cycles, uint32_t iterations) {
+    char line[96];
+    uint32_t old_per = (uint32_t)(old_cycles / iterations);
+    uint32_t new_per = (uint32_t)(new_cycles / iterations);
+    uint32_t speedup = new_cycles ? (uint32_t)(old_cycles * 10 / new_cycles) : 0;
+    snprintf(line, sizeof(line), "fmtbench %-10s old %5u new %5u cycles/call (x%u.%u)\n",
+             name, old_per, new_per, speedup / 10, speedup % 10);
+    sys_print(line);
+}
+
+/* Compares both implementations on the same values */
+static int verify(uint32_t count) {
+    char a[72], b[72];
+    uint64_t state = 0x2545F4914F6CDD1Dull;
+    static const int bases[] = { 2, 8, 10, 16, 36 };
+    
+    for (uint32_t i = 0; i < count; i++) {
+        uint64_t v = next_value(&state);
+        int base = bases[i % 5];
+        if (itoa64(v, a, base) != old_itoa64(v, b, base) || strcmp(a, b) != 0) {
+            sys_print("fmtbench: itoa64 mismatch\n");
+            return -1;
+        }
+        if (itoa((unsigned int)v, a, base) != old_itoa((unsigned int)v, b, base) || strcmp(a, b) != 0) {
+            sys_print("fmtbench: itoa mismatch\n");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    uint32_t iterations = DEFAULT_ITERATIONS;
+    if (argc > 1) {
+        uint32_t v = parse_uint(argv[1]);
+        if (v > 0) iterations = v;
+    }
+    
+    if (verify(iterations) < 0) return 1;
+    
+    report("u32 dec", time32(0, 10, iterations), time32(1, 10, iterations), iterations);
+    report("u32 hex", time32(0, 16, iterations), time32(1, 16, iterations), iterations);
+    report("u64 dec", time64(0, 10, iterations), time64(1, 10, iterations), iterations);
+    report("u64 hex", time64(0, 16, iterations), time64(1, 16, iterations), iterations);
+    return 0;
+}
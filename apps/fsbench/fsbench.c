@@ -0,0 +1,159 @@
+/*
+ * fsbench.c - Filesystem throughput and metadata benchmark for IPO_OS
+ *
+ * Writes a file sequentially, reads it back, then creates, stats and
+ * deletes a batch of small files in a fresh directory. Every result is
+ * one "fsbench <metric> <value> <unit>" line so that `make bench` logs
+ * can be compared with a plain diff or grep.
+ *
+ * Usage: fsbench [file size in KB] [file count]
+ */
+
+#include <syscall.h>
+#include <stdio.h>
+#include <file_system/ipo_fs.h>
+
+#define DEFAULT_KB     1024
+#define DEFAULT_FILES  64
+#define CHUNK_SIZE     (16 * 1024)
+
+#define DATA_PATH  "/fsbench.dat"
+#define DIR_PATH   "/fsbench.d"
+
+static inline uint64_t rdtsc(void) {
+    uint32_t lo, hi;
+    __asm__ volatile ("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+static uint32_t parse_uint(const char *s) {
+    uint32_t v = 0;
+    while (*s >= '0' && *s <= '9') {
+        v = v * 10 + (uint32_t)(*s++ - '0');
+    }
+    return v;
+}
+
+static void report(const char *metric, uint32_t value, const char *unit) {
+    char line[96];
+    snprintf(line, sizeof(line), "fsbench %s %u %s\n", metric, value, unit);
+    sys_print(line);
+}
+
+static uint32_t cycles_to_us(uint64_t cycles, uint32_t khz) {
+    return (uint32_t)(cycles * 1000 / khz);
+}
+
+/* Amount per second, given the time in microseconds */
+static uint32_t per_second(uint32_t amount, uint32_t us) {
+    return us ? (uint32_t)((uint64_t)amount * 1000000 / us) : 0;
+}
+
+/**
+ * bench_sequential - Writes then reads kb kilobytes in CHUNK_SIZE pieces
+ */
+static int bench_sequential(uint32_t kb, uint32_t khz) {
+    uint8_t *buf = sys_malloc(CHUNK_SIZE);
+    if (!buf) return -1;
+    
+    sys_delete(DATA_PATH);
+    if (sys_create(DATA_PATH, IPO_INODE_TYPE_FILE) < 0) {
+        sys_print("fsbench: cannot create " DATA_PATH "\n");
+        sys_free(buf);
+        return -1;
+    }
+    int fd = sys_open(DATA_PATH);
+    if (fd < 0) {
+        sys_free(buf);
+        return -1;
+    }
+    
+    uint32_t total = kb * 1024;
+    for (uint32_t i = 0; i < CHUNK_SIZE; i++) buf[i] = (uint8_t)i;
+    
+    uint64_t start = rdtsc();
+    for (uint32_t off = 0; off < total; off += CHUNK_SIZE) {
+        uint32_t n = total - off < CHUNK_SIZE ? total - off : CHUNK_SIZE;
+        if (sys_write(fd, buf, n, off) != (int)n) {
+            sys_print("fsbench: write failed\n");
+            break;
+        }
+    }
+    uint32_t write_us = cycles_to_us(rdtsc() - start, khz);
+    
+    start = rdtsc();
+    for (uint32_t off = 0; off < total; off += CHUNK_SIZE) {
+        uint32_t n = total - off < CHUNK_SIZE ? total - off : CHUNK_SIZE;
+        if (sys_read(fd, buf, n, off) != (int)n) {
+            sys_print("fsbench: read failed\n");
+            break;
+        }
+    }
+    uint32_t read_us = cycles_to_us(rdtsc() - start, khz);
+    
+    sys_close(fd);
+    sys_delete(DATA_PATH);
+    sys_free(buf);
+    
+    report("seq_write", per_second(kb, write_us), "KB/s");
+    report("seq_read", per_second(kb, read_us), "KB/s");
+    return 0;
+}
+
+/**
+ * bench_metadata - Creates, stats and deletes count files in one directory
+ */
+static int bench_metadata(uint32_t count, uint32_t khz) {
+    char path[64];
+    struct ipo_inode st;
+    
+    if (sys_create(DIR_PATH, IPO_INODE_TYPE_DIR) < 0) {
+        sys_print("fsbench: cannot create " DIR_PATH "\n");
+        return -1;
+    }
+    
+    uint64_t start = rdtsc();
+    for (uint32_t i = 0; i < count; i++) {
+        snprintf(path, sizeof(path), DIR_PATH "/f%u", i);
+        sys_create(path, IPO_INODE_TYPE_FILE);
+    }
+    uint32_t create_us = cycles_to_us(rdtsc() - start, khz);
+    
+    start = rdtsc();
+    for (uint32_t i = 0; i < count; i++) {
+        snprintf(path, sizeof(path), DIR_PATH "/f%u", i);
+        sys_stat(path, &st);
+    }
+    uint32_t stat_us = cycles_to_us(rdtsc() - start, khz);
+    
+    start = rdtsc();
+    for (uint32_t i = 0; i < count; i++) {
+        snprintf(path, sizeof(path), DIR_PATH "/f%u", i);
+        sys_delete(path);
+    }
+    uint32_t delete_us = cycles_to_us(rdtsc() - start, khz);
+    
+    sys_delete(DIR_PATH);
+    
+    report("create", per_second(count, create_us), "ops/s");
+    report("stat", per_second(count, stat_us), "ops/s");
+    report("delete", per_second(count, delete_us), "ops/s");
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    uint32_t kb = DEFAULT_KB;
+    uint32_t files = DEFAULT_FILES;
+    if (argc > 1 && parse_uint(argv[1]) > 0) kb = parse_uint(argv[1]);
+    if (argc > 2 && parse_uint(argv[2]) > 0) files = parse_uint(argv[2]);
+    
+    uint32_t khz = sys_tsc_khz();
+    if (khz == 0) {
+        sys_print("fsbench: TSC not calibrated\n");
+        return 1;
+    }
+    
+    if (bench_sequential(kb, khz) < 0) return 1;
+    if (bench_metadata(files, khz) < 0) return 1;
+    return 0;
+}
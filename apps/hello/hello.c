@@ -5,28 +5,28 @@
  * can be run from the terminal or autorun.
  */
 
-#include <stdio.h>
+#include <syscall.h>
 
 /**
  * main - Application entry point
  * 
  * Called by the process manager after loading the IPOB executable.
- * Runs in kernel context with access to all kernel APIs.
+ * Runs in ring 3 and reaches the kernel only through system calls.
  * 
  * @argc: Number of command-line arguments
  * @argv: Array of command-line argument strings
  */
 int main(int argc, char **argv) {
     if (argc == 1) {
-        printf("Hello, World!\n");
+        sys_print("Hello, World!\n");
         return 0;
     }
 
     for (int i = 1; i < argc; i++) {
-        printf("Hello, ");
-        printf(argv[i]);
-        printf("!\n");
+        sys_print("Hello, ");
+        sys_print(argv[i]);
+        sys_print("!\n");
     }
 
     return 0;
-}
\ No newline at end of file
+}
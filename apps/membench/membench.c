@@ -0,0 +1,108 @@
+/*
+ * membench.c - Memory routine throughput benchmark for IPO_OS
+ *
+ * Times memcpy, memmove (overlapping), memset, memcmp (equal buffers)
+ * and strlen for each size class and reports MB/s, using the TSC
+ * frequency calibrated by the kernel.
+ *
+ * Usage: membench [megabytes per measurement]
+ */
+
+#include <syscall.h>
+#include <stdio.h>
+#include <string.h>
+
+#define DEFAULT_MB   16
+#define MAX_SIZE     (256 * 1024)
+
+static const uint32_t sizes[] = { 16, 64, 256, 1024, 4096, 65536, MAX_SIZE };
+#define SIZE_COUNT (sizeof(sizes) / sizeof(sizes[0]))
+
+enum { OP_MEMCPY, OP_MEMMOVE, OP_MEMSET, OP_MEMCMP, OP_STRLEN, OP_COUNT };
+
+static inline uint64_t rdtsc(void) {
+    uint32_t lo, hi;
+    __asm__ volatile ("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+static uint32_t parse_uint(const char *s) {
+    uint32_t v = 0;
+    while (*s >= '0' && *s <= '9') {
+        v = v * 10 + (uint32_t)(*s++ - '0');
+    }
+    return v;
+}
+
+/* Cycles for `iterations` runs of one operation on `size` bytes */
+static uint64_t run(int op, uint8_t *dst, uint8_t *src, uint32_t size, uint32_t iterations) {
+    volatile uint32_t sink = 0;
+    uint64_t start = rdtsc();
+    
+    for (uint32_t i = 0; i < iterations; i++) {
+        switch (op) {
+        case OP_MEMCPY:  memcpy(dst, src, size); break;
+        case OP_MEMMOVE: memmove(src + 1, src, size - 1); break;
+        case OP_MEMSET:  memset(dst, (int)i, size); break;
+        case OP_MEMCMP:  sink += (uint32_t)memcmp(dst, src, size); break;
+        case OP_STRLEN:  sink += strlen((const char *)src); break;
+        }
+    }
+    
+    (void)sink;
+    return rdtsc() - start;
+}
+
+/* Bytes over cycles at khz kHz, in MB/s */
+static uint32_t mb_per_s(uint64_t bytes, uint64_t cycles, uint32_t khz) {
+    if (cycles == 0) return 0;
+    return (uint32_t)(bytes * khz / cycles / 1000);
+}
+
+int main(int argc, char **argv) {
+    uint32_t mb = DEFAULT_MB;
+    if (argc > 1) {
+        uint32_t v = parse_uint(argv[1]);
+        if (v > 0) mb = v;
+    }
+    
+    uint32_t khz = sys_tsc_khz();
+    if (khz == 0) {
+        sys_print("membench: TSC not calibrated\n");
+        return 1;
+    }
+    
+    uint8_t *src = sys_malloc(MAX_SIZE + 4);
+    uint8_t *dst = sys_malloc(MAX_SIZE + 4);
+    if (!src || !dst) {
+        sys_print("membench: out of memory\n");
+        return 1;
+    }
+    
+    char line[128];
+    sys_print("    size   memcpy  memmove   memset   memcmp   strlen  (MB/s)\n");
+    
+    for (uint32_t s = 0; s < SIZE_COUNT; s++) {
+        uint32_t size = sizes[s];
+        uint32_t iterations = (mb * 1024 * 1024) / size;
+        uint32_t rate[OP_COUNT];
+        
+        for (int op = 0; op < OP_COUNT; op++) {
+            // Same contents in both buffers and a terminator at the end for strlen
+            memset(src, 'a', size);
+            src[size - 1] = '\0';
+            memcpy(dst, src, size);
+            
+            uint64_t cycles = run(op, dst, src, size, iterations);
+            rate[op] = mb_per_s((uint64_t)size * iterations, cycles, khz);
+        }
+        
+        snprintf(line, sizeof(line), "%8u %8u %8u %8u %8u %8u\n", size,
+                 rate[OP_MEMCPY], rate[OP_MEMMOVE], rate[OP_MEMSET], rate[OP_MEMCMP], rate[OP_STRLEN]);
+        sys_print(line);
+    }
+    
+    sys_free(src);
+    sys_free(dst);
+    return 0;
+}
@@ -0,0 +1,74 @@
+/*
+ * sysbench.c - System call latency benchmark for IPO_OS
+ *
+ * Measures the round trip cost of a trivial system call (SYS_GETPID)
+ * through the int 0x80 gate and through the SYSENTER/SYSEXIT fast path.
+ *
+ * Usage: sysbench [iterations]
+ */
+
+#include <syscall.h>
+#include <stdio.h>
+
+#define DEFAULT_ITERATIONS 100000
+
+static inline uint64_t rdtsc(void) {
+    uint32_t lo, hi;
+    __asm__ volatile ("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+static int has_sysenter(void) {
+    uint32_t eax, ebx, ecx, edx;
+    __asm__ volatile ("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(1));
+    return (edx & (1u << 11)) != 0;
+}
+
+static uint32_t parse_uint(const char *s) {
+    uint32_t v = 0;
+    while (*s >= '0' && *s <= '9') {
+        v = v * 10 + (uint32_t)(*s++ - '0');
+    }
+    return v;
+}
+
+static void report(const char *name, uint64_t cycles, uint32_t iterations) {
+    char line[96];
+    uint32_t per_call = (uint32_t)(cycles / iterations);
+    snprintf(line, sizeof(line), "%s: %d cycles/call (%d calls)\n", name, per_call, iterations);
+    sys_print(line);
+}
+
+int main(int argc, char **argv) {
+    uint32_t iterations = DEFAULT_ITERATIONS;
+    if (argc > 1) {
+        uint32_t v = parse_uint(argv[1]);
+        if (v > 0) iterations = v;
+    }
+
+    /* Loop overhead on its own, subtracted from both results */
+    uint64_t start = rdtsc();
+    for (uint32_t i = 0; i < iterations; i++) {
+        __asm__ volatile ("" ::: "memory");
+    }
+    uint64_t overhead = rdtsc() - start;
+
+    start = rdtsc();
+    for (uint32_t i = 0; i < iterations; i++) {
+        syscall_int80(SYS_GETPID, 0, 0, 0, 0);
+    }
+    report("int 0x80", rdtsc() - start - overhead, iterations);
+
+    if (!has_sysenter()) {
+        sys_print("sysenter: not supported by this CPU\n");
+        return 0;
+    }
+
+    start = rdtsc();
+    for (uint32_t i = 0; i < iterations; i++) {
+        syscall_sysenter(SYS_GETPID, 0, 0, 0, 0);
+    }
+    report("sysenter", rdtsc() - start - overhead, iterations);
+
+    return 0;
+}
@@ -5,25 +5,70 @@ import os
 import struct
 import sys
 
-BLOCK_SIZE = 512
+SECTOR_SIZE = 512
+DEFAULT_BLOCK_SIZE = 4096
+MAX_BLOCK_SIZE = 8192
 IPO_FS_MAX_NAME = 64
 IPO_FS_DIRECT_BLOCKS = 6
 IPO_INODE_TYPE_DIR = 0x1
 IPO_INODE_TYPE_FILE = 0x2
-
-SB_FMT = '<8sIIIIIII'
+IPO_INODE_FLAG_PROTECTED = 0x80000000
+IPO_INODE_FLAG_EXTENTS = 0x40000000
+
+IPO_FS_REVISION = 1
+IPO_FS_FEATURE_LAZY_INIT = 0x1
+IPO_FS_FEATURE_EXTENTS = 0x2
+IPO_FS_FEATURE_DIR_INDEX = 0x4
+IPO_FS_FEATURES_KNOWN = (IPO_FS_FEATURE_LAZY_INIT | IPO_FS_FEATURE_EXTENTS |
+                         IPO_FS_FEATURE_DIR_INDEX)
+
+# magic, revision, 7 layout fields; revision 1 adds features and the
+# lazy init marks of the inode bitmap, block bitmap and inode table
+SB_FMT = '<7sBIIIIIIIIIII'
+SB_FIELDS = ('fs_size_blocks', 'block_size', 'inode_count', 'inode_bitmap_start',
+             'block_bitmap_start', 'inode_table_start', 'data_blocks_start',
+             'features', 'inode_bitmap_init', 'block_bitmap_init', 'inode_table_init')
 SB_SIZE = struct.calcsize(SB_FMT)
-INODE_FMT = '<III' + ('I' * IPO_FS_DIRECT_BLOCKS) + 'II32s'
+# ... block pointers, generation, then the directory hash index fields
+INODE_FMT = '<III' + ('I' * IPO_FS_DIRECT_BLOCKS) + 'II' + 'IIIII12s'
+INODE_INDEX_FIELDS = ('index_start', 'index_blocks', 'index_used', 'index_deleted')
 INODE_SIZE = struct.calcsize(INODE_FMT)
-INODES_PER_BLOCK = BLOCK_SIZE // INODE_SIZE
 DIRENTRY_FMT = '<I B B 2s {}s'.format(IPO_FS_MAX_NAME)
 DIRENTRY_SIZE = struct.calcsize(DIRENTRY_FMT)
 
+# extent tree: the inode's block pointers hold a header and two entries;
+# larger trees spill into blocks of the same layout
+EXTENT_MAGIC = 0xE47E
+EXTENT_HDR_FMT = '<HHHH'  # magic, entries, max, depth
+EXTENT_FMT = '<III'       # logical, physical, length (0 in index nodes)
+EXTENT_HDR_SIZE = struct.calcsize(EXTENT_HDR_FMT)
+EXTENT_SIZE = struct.calcsize(EXTENT_FMT)
+EXTENT_ROOT_MAX = 2
+
+# directory hash index: open-addressed (hash, entry + 1) slots probed
+# linearly; kept for directories that outgrow their first block
+DIR_INDEX_SLOT_FMT = '<II'
+DIR_INDEX_SLOT_SIZE = struct.calcsize(DIR_INDEX_SLOT_FMT)
+DIR_INDEX_MAX_BLOCKS = 256
+
+
+def dir_name_hash(name):
+    """FNV-1a, as the kernel hashes directory entry names"""
+    h = 2166136261
+    for b in name:
+        h = ((h ^ b) * 16777619) & 0xFFFFFFFF
+    return h
+
 
 class DiskError(Exception):
     pass
 
 
+def valid_block_size(size):
+    """Blocks are a power of two sectors, up to MAX_BLOCK_SIZE"""
+    return SECTOR_SIZE <= size <= MAX_BLOCK_SIZE and size & (size - 1) == 0
+
+
 class DiskImage:
     def __init__(self, path, start_lba=2048, require_format=False):
         if not os.path.exists(path):
@@ -32,6 +77,7 @@ class DiskImage:
         self.start_lba = start_lba
         self.f = open(path, 'r+b')
         self.sb = None
+        self.block_size = SECTOR_SIZE
         try:
             self._load_superblock()
         except DiskError as e:
@@ -47,55 +93,124 @@ class DiskImage:
 
     # ================= BLOCK IO =================
 
+    @property
+    def inodes_per_block(self):
+        return self.block_size // INODE_SIZE
+
+    @property
+    def dir_entries_per_block(self):
+        return self.block_size // DIRENTRY_SIZE
+
+    @property
+    def extent_block_max(self):
+        return (self.block_size - EXTENT_HDR_SIZE) // EXTENT_SIZE
+
     def _seek_block(self, idx):
-        self.f.seek((self.start_lba + idx) * BLOCK_SIZE)
+        self.f.seek(self.start_lba * SECTOR_SIZE + idx * self.block_size)
 
-    def read_block(self, idx):
+    def _raw_read(self, idx):
         self._seek_block(idx)
-        data = self.f.read(BLOCK_SIZE)
-        if len(data) != BLOCK_SIZE:
+        data = self.f.read(self.block_size)
+        if len(data) != self.block_size:
             raise DiskError("short read")
         return data
 
-    def write_block(self, idx, data):
-        if len(data) != BLOCK_SIZE:
+    def _raw_write(self, idx, data):
+        if len(data) != self.block_size:
             raise DiskError("bad block size")
         self._seek_block(idx)
         self.f.write(data)
-        self.f.flush()
-        os.fsync(self.f.fileno())
+
+    def _lazy_region(self, idx):
+        """(start, mark key) of the lazily initialised region holding idx, or None"""
+        sb = self.sb
+        if not sb or not (sb['features'] & IPO_FS_FEATURE_LAZY_INIT):
+            return None
+        if idx < sb['inode_bitmap_start'] or idx >= sb['data_blocks_start']:
+            return None
+        if idx >= sb['inode_table_start']:
+            return sb['inode_table_start'], 'inode_table_init'
+        if idx >= sb['block_bitmap_start']:
+            return sb['block_bitmap_start'], 'block_bitmap_init'
+        return sb['inode_bitmap_start'], 'inode_bitmap_init'
+
+    def read_block(self, idx):
+        region = self._lazy_region(idx)
+        if region and idx - region[0] >= self.sb[region[1]]:
+            return b'\x00' * self.block_size
+        return self._raw_read(idx)
+
+    def write_block(self, idx, data):
+        region = self._lazy_region(idx)
+        if region and idx - region[0] >= self.sb[region[1]]:
+            # same order as the kernel: zero the gap, record the mark, then write
+            start, key = region
+            for i in range(start + self.sb[key], idx + 1):
+                self._raw_write(i, b'\x00' * self.block_size)
+            self.sb[key] = idx - start + 1
+            self._write_superblock()
+        self._raw_write(idx, data)
 
     # ================= SUPERBLOCK =================
 
     def _load_superblock(self):
-        buf = self.read_block(0)
-        sb = struct.unpack(SB_FMT, buf[:SB_SIZE])
+        # the superblock sits in the first sector, whatever the block size
+        self.f.seek(self.start_lba * SECTOR_SIZE)
+        buf = self.f.read(SB_SIZE)
+        if len(buf) != SB_SIZE:
+            raise DiskError("short read")
+        sb = struct.unpack(SB_FMT, buf)
         if sb[0].rstrip(b'\x00') != b'IPO_FS':
             raise DiskError("not IPO_FS")
-        self.sb = {
-            'fs_size_blocks': sb[1],
-            'block_size': sb[2],
-            'inode_count': sb[3],
-            'inode_bitmap_start': sb[4],
-            'block_bitmap_start': sb[5],
-            'inode_table_start': sb[6],
-            'data_blocks_start': sb[7],
-        }
+        revision = sb[1]
+        if revision > IPO_FS_REVISION:
+            raise DiskError(f"unknown IPO_FS revision {revision}")
+        self.sb = dict(zip(SB_FIELDS, sb[2:]))
+        if revision == 0:
+            # older images left everything after data_blocks_start uninitialised
+            for key in SB_FIELDS[7:]:
+                self.sb[key] = 0
+        if self.sb['features'] & ~IPO_FS_FEATURES_KNOWN:
+            raise DiskError(f"unknown IPO_FS features {self.sb['features']:#x}")
+        if not valid_block_size(self.sb['block_size']):
+            raise DiskError(f"unsupported block size {self.sb['block_size']}")
+        self.block_size = self.sb['block_size']
+        self.revision = revision
+
+    def _write_superblock(self):
+        sb_data = struct.pack(SB_FMT, b'IPO_FS\x00', self.revision,
+                              *(self.sb[key] for key in SB_FIELDS))
+        self.f.seek(self.start_lba * SECTOR_SIZE)
+        self.f.write(sb_data.ljust(SECTOR_SIZE, b'\x00'))
+
+    def _write_dir_dots(self, block, ino, parent):
+        de_dot = struct.pack(DIRENTRY_FMT, ino, IPO_INODE_TYPE_DIR, 1, b'\x00\x00',
+                             b'.'.ljust(IPO_FS_MAX_NAME, b'\x00'))
+        de_ddot = struct.pack(DIRENTRY_FMT, parent, IPO_INODE_TYPE_DIR, 2, b'\x00\x00',
+                              b'..'.ljust(IPO_FS_MAX_NAME, b'\x00'))
+        self.write_block(block, (de_dot + de_ddot).ljust(self.block_size, b'\x00'))
+        return len(de_dot) + len(de_ddot)
+
+    def format_disk(self, total_inodes=256, block_size=DEFAULT_BLOCK_SIZE):
+        """Format disk with a new IPO_FS filesystem, lazily like the kernel:
+        only the superblock, root, /app and /autorun are written"""
+        if not valid_block_size(block_size):
+            raise DiskError(f"unsupported block size {block_size}")
+        self.block_size = block_size
 
-    def format_disk(self, total_inodes=256):
-        """Format disk with a new IPO_FS filesystem"""
         # Get disk size  
         self.f.seek(0, 2)  # seek to end
-        disk_size = self.f.tell() // BLOCK_SIZE
-        total_blocks = disk_size - self.start_lba
+        disk_sectors = self.f.tell() // SECTOR_SIZE
+        total_blocks = (disk_sectors - self.start_lba) // (block_size // SECTOR_SIZE)
         
         if total_blocks < 100:
             raise DiskError("disk too small")
         
         # Calculate layout
-        inode_bitmap_blocks = (total_inodes + 4095) // 4096
-        block_bitmap_blocks = (total_blocks + 4095) // 4096
-        inode_table_blocks = (total_inodes * INODE_SIZE + BLOCK_SIZE - 1) // BLOCK_SIZE
+        bits_per_block = block_size * 8
+        inode_bitmap_blocks = (total_inodes + bits_per_block - 1) // bits_per_block
+        block_bitmap_blocks = (total_blocks + bits_per_block - 1) // bits_per_block
+        inode_table_blocks = (total_inodes * INODE_SIZE + block_size - 1) // block_size
         
         inode_bitmap_start = 1
         block_bitmap_start = inode_bitmap_start + inode_bitmap_blocks
@@ -103,60 +218,49 @@ class DiskImage:
         data_blocks_start = inode_table_start + inode_table_blocks
         
         # Create superblock
+        self.revision = IPO_FS_REVISION
         self.sb = {
             'fs_size_blocks': total_blocks,
-            'block_size': BLOCK_SIZE,
+            'block_size': block_size,
             'inode_count': total_inodes,
             'inode_bitmap_start': inode_bitmap_start,
             'block_bitmap_start': block_bitmap_start,
             'inode_table_start': inode_table_start,
             'data_blocks_start': data_blocks_start,
+            'features': (IPO_FS_FEATURE_LAZY_INIT | IPO_FS_FEATURE_EXTENTS |
+                         IPO_FS_FEATURE_DIR_INDEX),
+            'inode_bitmap_init': 0,
+            'block_bitmap_init': 0,
+            'inode_table_init': 0,
         }
+        self._write_superblock()
         
-        # Write superblock
-        magic = b'IPO_FS\x00\x00'
-        sb_data = struct.pack(SB_FMT,
-            magic,
-            self.sb['fs_size_blocks'],
-            self.sb['block_size'],
-            self.sb['inode_count'],
-            self.sb['inode_bitmap_start'],
-            self.sb['block_bitmap_start'],
-            self.sb['inode_table_start'],
-            self.sb['data_blocks_start'],
-        )
-        # Pad to BLOCK_SIZE
-        sb_block = sb_data + b'\x00' * (BLOCK_SIZE - len(sb_data))
-        self.write_block(0, sb_block)
-        
-        # Zero out bitmaps and inode table
-        zero_block = b'\x00' * BLOCK_SIZE
-        for i in range(inode_bitmap_start, inode_table_start + inode_table_blocks):
-            self.write_block(i, zero_block)
-        
-        # Allocate root inode and create root directory
-        self.bitmap_set(inode_bitmap_start, 0, 1)  # inode 1 is root
-        root_inode = {
-            'mode': IPO_INODE_TYPE_DIR,
-            'size': 0,
-            'links_count': 1,
-            'direct': [0] * IPO_FS_DIRECT_BLOCKS,
-            'indirect': 0,
-            'double_indirect': 0,
-        }
+        # Root directory is inode 1
+        self.bitmap_set(inode_bitmap_start, 0, 1)
+        root_inode = self.empty_inode()
+        root_inode['mode'] = IPO_INODE_TYPE_DIR
+        root_inode['links_count'] = 2
+        root_inode['direct'][0] = self.allocate_block()
+        root_inode['size'] = self._write_dir_dots(root_inode['direct'][0], 1, 1)
         self.write_inode(1, root_inode)
         
-        # Create /app directory
-        self.bitmap_set(inode_bitmap_start, 1, 1)  # inode 2 is /app
-        app_inode = {
-            'mode': IPO_INODE_TYPE_DIR,
-            'size': 0,
-            'links_count': 1,
-            'direct': [0] * IPO_FS_DIRECT_BLOCKS,
-            'indirect': 0,
-            'double_indirect': 0,
-        }
-        self.write_inode(2, app_inode)
+        # Protected /app directory and /autorun file
+        app = self.allocate_inode()
+        app_inode = self.empty_inode()
+        app_inode['mode'] = IPO_INODE_TYPE_DIR | IPO_INODE_FLAG_PROTECTED
+        app_inode['links_count'] = 2
+        app_inode['direct'][0] = self.allocate_block()
+        app_inode['size'] = self._write_dir_dots(app_inode['direct'][0], app, 1)
+        self.write_inode(app, app_inode)
+        self.dir_add_entry(1, 'app', app, IPO_INODE_TYPE_DIR)
+
+        autorun = self.allocate_inode()
+        autorun_inode = self.empty_inode()
+        autorun_inode['mode'] = IPO_INODE_TYPE_FILE | IPO_INODE_FLAG_PROTECTED | IPO_INODE_FLAG_EXTENTS
+        autorun_inode['links_count'] = 1
+        autorun_inode['extents'] = []
+        self.write_inode(autorun, autorun_inode)
+        self.dir_add_entry(1, 'autorun', autorun, IPO_INODE_TYPE_FILE)
         
         print("Disk formatted successfully")
     # ================= INODES =================
@@ -165,48 +269,60 @@ class DiskImage:
         if ino <= 0 or ino > self.sb['inode_count']:
             raise DiskError("invalid inode")
         idx = ino - 1
-        block = self.sb['inode_table_start'] + idx // INODES_PER_BLOCK
-        offset = (idx % INODES_PER_BLOCK) * INODE_SIZE
+        block = self.sb['inode_table_start'] + idx // self.inodes_per_block
+        offset = (idx % self.inodes_per_block) * INODE_SIZE
         raw = self.read_block(block)[offset:offset + INODE_SIZE]
         t = struct.unpack(INODE_FMT, raw)
-        return {
+        inode = {
             'mode': t[0],
             'size': t[1],
             'links_count': t[2],
             'direct': list(t[3:3 + IPO_FS_DIRECT_BLOCKS]),
             'indirect': t[3 + IPO_FS_DIRECT_BLOCKS],
             'double_indirect': t[3 + IPO_FS_DIRECT_BLOCKS + 1],
+            'generation': t[5 + IPO_FS_DIRECT_BLOCKS],
         }
+        inode.update(zip(INODE_INDEX_FIELDS, t[6 + IPO_FS_DIRECT_BLOCKS:10 + IPO_FS_DIRECT_BLOCKS]))
+        if inode['mode'] & IPO_INODE_FLAG_EXTENTS:
+            # the block pointers hold the extent root instead
+            inode['extent_depth'], inode['extents'] = self._unpack_extent_node(raw[12:])
+        return inode
 
     def write_inode(self, ino, inode):
         idx = ino - 1
-        block = self.sb['inode_table_start'] + idx // INODES_PER_BLOCK
-        offset = (idx % INODES_PER_BLOCK) * INODE_SIZE
+        block = self.sb['inode_table_start'] + idx // self.inodes_per_block
+        offset = (idx % self.inodes_per_block) * INODE_SIZE
         buf = bytearray(self.read_block(block))
         packed = struct.pack(
             INODE_FMT,
             inode['mode'], inode['size'], inode['links_count'],
-            *inode['direct'], inode['indirect'], inode['double_indirect'], b'\x00' * 32
+            *inode['direct'], inode['indirect'], inode['double_indirect'],
+            inode.get('generation', 0), *(inode.get(f, 0) for f in INODE_INDEX_FIELDS), b'\x00' * 12
         )
+        if inode['mode'] & IPO_INODE_FLAG_EXTENTS:
+            root = self._pack_extent_node(inode.get('extent_depth', 0), inode['extents'], EXTENT_ROOT_MAX)
+            packed = packed[:12] + root + packed[12 + len(root):]
         buf[offset:offset + INODE_SIZE] = packed
         self.write_block(block, bytes(buf))
 
     def empty_inode(self):
         return {'mode': 0, 'size': 0, 'links_count': 0,
-                'direct': [0] * IPO_FS_DIRECT_BLOCKS, 'indirect': 0, 'double_indirect': 0}
+                'direct': [0] * IPO_FS_DIRECT_BLOCKS, 'indirect': 0, 'double_indirect': 0,
+                'generation': 0, 'index_start': 0, 'index_blocks': 0,
+                'index_used': 0, 'index_deleted': 0}
 
     # ================= BITMAPS =================
 
     def bitmap_get(self, start, bit):
         byte = bit // 8
-        block = byte // BLOCK_SIZE
-        off = byte % BLOCK_SIZE
+        block = byte // self.block_size
+        off = byte % self.block_size
         return (self.read_block(start + block)[off] >> (bit & 7)) & 1
 
     def bitmap_set(self, start, bit, val):
         byte = bit // 8
-        block = byte // BLOCK_SIZE
-        off = byte % BLOCK_SIZE
+        block = byte // self.block_size
+        off = byte % self.block_size
         buf = bytearray(self.read_block(start + block))
         if val:
             buf[off] |= 1 << (bit & 7)
@@ -229,13 +345,30 @@ class DiskImage:
         for i in range(total):
             if not self.bitmap_get(self.sb['block_bitmap_start'], i):
                 self.bitmap_set(self.sb['block_bitmap_start'], i, 1)
-                self.write_block(self.sb['data_blocks_start'] + i, b'\x00' * BLOCK_SIZE)
+                self.write_block(self.sb['data_blocks_start'] + i, b'\x00' * self.block_size)
                 return self.sb['data_blocks_start'] + i
         return -1
 
+    def allocate_blocks(self, count):
+        """Allocates count contiguous zeroed blocks; returns the first"""
+        total = self.sb['fs_size_blocks'] - self.sb['data_blocks_start']
+        run = 0
+        for i in range(total):
+            run = 0 if self.bitmap_get(self.sb['block_bitmap_start'], i) else run + 1
+            if run == count:
+                first = i + 1 - count
+                for j in range(first, i + 1):
+                    self.bitmap_set(self.sb['block_bitmap_start'], j, 1)
+                    self.write_block(self.sb['data_blocks_start'] + j, b'\x00' * self.block_size)
+                return self.sb['data_blocks_start'] + first
+        return -1
+
     # ================= BLOCKS FOR INODE =================
 
     def get_block_for_inode(self, inode, logical, alloc=False):
+        if inode['mode'] & IPO_INODE_FLAG_EXTENTS:
+            # extent files are only ever written whole, by _write_file_data
+            return self._extent_map(inode, logical)
         if logical < IPO_FS_DIRECT_BLOCKS:
             if inode['direct'][logical] == 0:
                 if not alloc:
@@ -244,7 +377,7 @@ class DiskImage:
             return inode['direct'][logical]
 
         idx = logical - IPO_FS_DIRECT_BLOCKS
-        per = BLOCK_SIZE // 4
+        per = self.block_size // 4
         
         # Single indirect
         if idx < per:
@@ -252,7 +385,7 @@ class DiskImage:
                 if not alloc:
                     return -1
                 inode['indirect'] = self.allocate_block()
-                self.write_block(inode['indirect'], b'\x00' * BLOCK_SIZE)
+                self.write_block(inode['indirect'], b'\x00' * self.block_size)
 
             ibuf = bytearray(self.read_block(inode['indirect']))
             ptr = struct.unpack('<I', ibuf[idx * 4:(idx + 1) * 4])[0]
@@ -273,7 +406,7 @@ class DiskImage:
             if not alloc:
                 return -1
             inode['double_indirect'] = self.allocate_block()
-            self.write_block(inode['double_indirect'], b'\x00' * BLOCK_SIZE)
+            self.write_block(inode['double_indirect'], b'\x00' * self.block_size)
         
         # Read double indirect block
         dibuf = bytearray(self.read_block(inode['double_indirect']))
@@ -288,7 +421,7 @@ class DiskImage:
             si_ptr = self.allocate_block()
             dibuf[di_idx * 4:(di_idx + 1) * 4] = struct.pack('<I', si_ptr)
             self.write_block(inode['double_indirect'], bytes(dibuf))
-            self.write_block(si_ptr, b'\x00' * BLOCK_SIZE)
+            self.write_block(si_ptr, b'\x00' * self.block_size)
         
         # Read single indirect block
         sibuf = bytearray(self.read_block(si_ptr))
@@ -302,6 +435,128 @@ class DiskImage:
         
         return ptr
 
+    # ================= EXTENTS =================
+
+    def _unpack_extent_node(self, raw):
+        magic, entries, _, depth = struct.unpack(EXTENT_HDR_FMT, raw[:EXTENT_HDR_SIZE])
+        if magic != EXTENT_MAGIC:
+            raise DiskError("bad extent node")
+        return depth, [struct.unpack_from(EXTENT_FMT, raw, EXTENT_HDR_SIZE + i * EXTENT_SIZE)
+                       for i in range(entries)]
+
+    def _pack_extent_node(self, depth, entries, max_entries):
+        raw = struct.pack(EXTENT_HDR_FMT, EXTENT_MAGIC, len(entries), max_entries, depth)
+        for e in entries:
+            raw += struct.pack(EXTENT_FMT, *e)
+        return raw.ljust(EXTENT_HDR_SIZE + max_entries * EXTENT_SIZE, b'\x00')
+
+    def _extent_map(self, inode, logical):
+        depth, entries = inode.get('extent_depth', 0), inode['extents']
+        while True:
+            prev = [e for e in entries if e[0] <= logical]
+            if not prev:
+                return -1
+            e = prev[-1]
+            if depth == 0:
+                return e[1] + (logical - e[0]) if logical < e[0] + e[2] else -1
+            depth, entries = self._unpack_extent_node(self.read_block(e[1]))
+
+    def _extent_blocks(self, depth, entries):
+        """Yields every data and tree node block below a node"""
+        for logical, phys, length in entries:
+            if depth == 0:
+                yield from range(phys, phys + length)
+            else:
+                yield from self._extent_blocks(*self._unpack_extent_node(self.read_block(phys)))
+                yield phys
+
+    def _build_extents(self, inode, blocks):
+        """Maps logical block i to blocks[i], spilling into extent blocks
+        when the runs do not fit in the inode"""
+        entries = []
+        for i, phys in enumerate(blocks):
+            if entries and entries[-1][1] + entries[-1][2] == phys:
+                entries[-1][2] += 1
+            else:
+                entries.append([i, phys, 1])
+        entries = [tuple(e) for e in entries]
+        depth = 0
+        while len(entries) > EXTENT_ROOT_MAX:
+            parents = []
+            for i in range(0, len(entries), self.extent_block_max):
+                chunk = entries[i:i + self.extent_block_max]
+                node = self.allocate_block()
+                if node < 0:
+                    raise DiskError('no free block')
+                self.write_block(node, self._pack_extent_node(depth, chunk, self.extent_block_max).ljust(self.block_size, b'\x00'))
+                parents.append((chunk[0][0], node, 0))
+            entries = parents
+            depth += 1
+        inode['extent_depth'] = depth
+        inode['extents'] = entries
+
+    def _free_data(self, inode):
+        """Releases every block of a file, in either mapping"""
+        def release(phys):
+            self.bitmap_set(self.sb['block_bitmap_start'], phys - self.sb['data_blocks_start'], 0)
+
+        if inode['mode'] & IPO_INODE_FLAG_EXTENTS:
+            for phys in list(self._extent_blocks(inode.get('extent_depth', 0), inode['extents'])):
+                release(phys)
+            inode['extent_depth'], inode['extents'] = 0, []
+            return
+
+        nblocks = (inode['size'] + self.block_size - 1) // self.block_size
+        for i in range(min(IPO_FS_DIRECT_BLOCKS, nblocks)):
+            if inode['direct'][i]:
+                release(inode['direct'][i])
+                inode['direct'][i] = 0
+        if inode['indirect']:
+            ibuf = self.read_block(inode['indirect'])
+            for j in range(0, self.block_size, 4):
+                ptr = struct.unpack('<I', ibuf[j:j+4])[0]
+                if ptr:
+                    release(ptr)
+            release(inode['indirect'])
+            inode['indirect'] = 0
+        if inode['double_indirect']:
+            dibuf = self.read_block(inode['double_indirect'])
+            for di in range(0, self.block_size, 4):
+                si_ptr = struct.unpack('<I', dibuf[di:di+4])[0]
+                if si_ptr:
+                    sibuf = self.read_block(si_ptr)
+                    for si in range(0, self.block_size, 4):
+                        ptr = struct.unpack('<I', sibuf[si:si+4])[0]
+                        if ptr:
+                            release(ptr)
+                    release(si_ptr)
+            release(inode['double_indirect'])
+            inode['double_indirect'] = 0
+        self._dir_index_free(inode)
+
+    def _write_file_data(self, ino, inode, data):
+        """Replaces a file's contents; new data is extent mapped when the
+        image supports it"""
+        self._free_data(inode)
+        if self.sb['features'] & IPO_FS_FEATURE_EXTENTS:
+            inode['mode'] |= IPO_INODE_FLAG_EXTENTS
+        bs = self.block_size
+        nblocks = (len(data) + bs - 1) // bs
+        blocks = []
+        for i in range(nblocks):
+            if inode['mode'] & IPO_INODE_FLAG_EXTENTS:
+                phys = self.allocate_block()
+                if phys < 0:
+                    raise DiskError('no free block')
+                blocks.append(phys)
+            else:
+                phys = self.get_block_for_inode(inode, i, alloc=True)
+            self.write_block(phys, data[i * bs:(i + 1) * bs].ljust(bs, b'\x00'))
+        if inode['mode'] & IPO_INODE_FLAG_EXTENTS:
+            self._build_extents(inode, blocks)
+        inode['size'] = len(data)
+        self.write_inode(ino, inode)
+
     # ================= PATH =================
 
     def path_resolve(self, path):
@@ -332,21 +587,26 @@ class DiskImage:
 
     # ================= DIRECTORY =================
 
+    def _dir_slot(self, index):
+        """(logical block, offset) of directory entry index; like the
+        kernel, entries never straddle a block boundary"""
+        per = self.dir_entries_per_block
+        return index // per, (index % per) * DIRENTRY_SIZE
+
+    def _dir_raw_entries(self, inode):
+        block_idx, blk = -1, b''
+        for i in range(inode['size'] // DIRENTRY_SIZE):
+            bidx, off = self._dir_slot(i)
+            if bidx != block_idx:
+                phys = self.get_block_for_inode(inode, bidx)
+                if phys < 0:
+                    return
+                block_idx, blk = bidx, self.read_block(phys)
+            yield blk[off:off + DIRENTRY_SIZE]
+
     def dir_entries(self, inode):
-        size = inode['size']
-        if size == 0:
-            return
-        buf = bytearray()
-        for b in range((size + BLOCK_SIZE - 1) // BLOCK_SIZE):
-            phys = self.get_block_for_inode(inode, b)
-            if phys < 0:
-                break
-            buf += self.read_block(phys)
-        for i in range(size // DIRENTRY_SIZE):
-            off = i * DIRENTRY_SIZE
-            inode_no, typ, namelen, _, name = struct.unpack(
-                DIRENTRY_FMT, buf[off:off + DIRENTRY_SIZE]
-            )
+        for raw in self._dir_raw_entries(inode):
+            inode_no, typ, namelen, _, name = struct.unpack(DIRENTRY_FMT, raw)
             if inode_no:
                 yield {'inode': inode_no, 'type': typ,
                        'name': name[:namelen].decode()}
@@ -364,14 +624,13 @@ class DiskImage:
             return False
         entry = struct.pack(DIRENTRY_FMT, ino, typ, len(name),
                             b'\x00\x00', name.encode().ljust(IPO_FS_MAX_NAME, b'\x00'))
-        off = din['size']
-        bidx = off // BLOCK_SIZE
-        rel = off % BLOCK_SIZE
+        bidx, rel = self._dir_slot(din['size'] // DIRENTRY_SIZE)
         phys = self.get_block_for_inode(din, bidx, alloc=True)
         blk = bytearray(self.read_block(phys))
         blk[rel:rel + DIRENTRY_SIZE] = entry
         self.write_block(phys, bytes(blk))
         din['size'] += DIRENTRY_SIZE
+        self._dir_index_update(din)
         self.write_inode(dirino, din)
         return True
 
@@ -380,47 +639,90 @@ class DiskImage:
         size = din['size']
         if size == 0:
             return False
-        nentries = size // DIRENTRY_SIZE
-        buf = bytearray()
-        blocks = (size + BLOCK_SIZE - 1) // BLOCK_SIZE
-        for bidx in range(blocks):
-            phys = self.get_block_for_inode(din, bidx, alloc=False)
-            if phys < 0:
-                return False
-            buf += self.read_block(phys)
+        blocks = self._dir_slot(size // DIRENTRY_SIZE - 1)[0] + 1
         found = False
-        newbuf = bytearray()
-        for i in range(nentries):
-            off = i * DIRENTRY_SIZE
-            chunk = buf[off:off + DIRENTRY_SIZE]
-            inode_no = struct.unpack('<I', chunk[:4])[0]
+        kept = []
+        for chunk in self._dir_raw_entries(din):
             name_len = chunk[5]
-            name_bytes = chunk[8:8 + IPO_FS_MAX_NAME]
-            entryname = name_bytes[:name_len].decode('utf-8', errors='ignore')
+            entryname = chunk[8:8 + name_len].decode('utf-8', errors='ignore')
             if entryname == name:
                 found = True
                 continue
-            newbuf += chunk
+            kept.append(chunk)
         if not found:
             return False
-        # write newbuf across blocks
-        new_size = len(newbuf)
-        blocks_needed = (new_size + BLOCK_SIZE - 1) // BLOCK_SIZE if new_size > 0 else 0
+        # write the remaining entries back, packed from the start
+        per = self.dir_entries_per_block
+        new_size = len(kept) * DIRENTRY_SIZE
+        blocks_needed = (len(kept) + per - 1) // per
         for bidx in range(blocks_needed):
             phys = self.get_block_for_inode(din, bidx, alloc=True)
-            chunk = newbuf[bidx * BLOCK_SIZE:(bidx + 1) * BLOCK_SIZE]
-            if len(chunk) < BLOCK_SIZE:
-                chunk = chunk.ljust(BLOCK_SIZE, b'\x00')
-            self.write_block(phys, chunk)
+            chunk = b''.join(kept[bidx * per:(bidx + 1) * per])
+            self.write_block(phys, chunk.ljust(self.block_size, b'\x00'))
         # free extra blocks
         for bidx in range(blocks_needed, blocks):
             phys = self.get_block_for_inode(din, bidx, alloc=False)
             if phys and phys >= self.sb['data_blocks_start']:
                 self.bitmap_set(self.sb['block_bitmap_start'], phys - self.sb['data_blocks_start'], 0)
+                if bidx < IPO_FS_DIRECT_BLOCKS:
+                    din['direct'][bidx] = 0
         din['size'] = new_size
+        self._dir_index_update(din)
         self.write_inode(dirino, din)
         return True
 
+    def _dir_index_free(self, din):
+        for i in range(din.get('index_blocks', 0)):
+            phys = din['index_start'] + i
+            self.bitmap_set(self.sb['block_bitmap_start'], phys - self.sb['data_blocks_start'], 0)
+        for f in INODE_INDEX_FIELDS:
+            din[f] = 0
+
+    def _dir_index_update(self, din):
+        """Rebuilds the hash index of a directory the editor changed, sized
+        like the kernel's; small directories have none"""
+        if not (self.sb['features'] & IPO_FS_FEATURE_DIR_INDEX):
+            return
+        count = din['size'] // DIRENTRY_SIZE
+        slots_per_block = self.block_size // DIR_INDEX_SLOT_SIZE
+        blocks = 0
+        if count > self.dir_entries_per_block:
+            blocks = 1
+            while blocks * slots_per_block < 2 * (count + 1):
+                blocks *= 2
+            if blocks > DIR_INDEX_MAX_BLOCKS:
+                blocks = 0
+        if din.get('index_blocks', 0) != blocks:
+            self._dir_index_free(din)
+            if blocks:
+                start = self.allocate_blocks(blocks)
+                if start < 0:
+                    return  # no room: lookups stay linear
+                din['index_start'], din['index_blocks'] = start, blocks
+        if not blocks:
+            return
+
+        mask = blocks * slots_per_block - 1
+        slots = [(0, 0)] * (mask + 1)
+        used = 0
+        for e, raw in enumerate(self._dir_raw_entries(din)):
+            inode_no, _, namelen, _, name = struct.unpack(DIRENTRY_FMT, raw)
+            if not inode_no:
+                continue
+            if not namelen:
+                namelen = name.find(b'\x00') if b'\x00' in name else IPO_FS_MAX_NAME
+            h = dir_name_hash(name[:namelen])
+            i = h & mask
+            while slots[i][1]:
+                i = (i + 1) & mask
+            slots[i] = (h, e + 1)
+            used += 1
+        table = b''.join(struct.pack(DIR_INDEX_SLOT_FMT, *slot) for slot in slots)
+        for b in range(blocks):
+            self.write_block(din['index_start'] + b,
+                             table[b * self.block_size:(b + 1) * self.block_size])
+        din['index_used'], din['index_deleted'] = used, 0
+
     # ================= USER COMMANDS =================
 
     def ls(self, path='/'):
@@ -440,7 +742,7 @@ class DiskImage:
         if inode['mode'] & 1:
             raise DiskError("is dir")
         data = bytearray()
-        for b in range((inode['size'] + BLOCK_SIZE - 1) // BLOCK_SIZE):
+        for b in range((inode['size'] + self.block_size - 1) // self.block_size):
             phys = self.get_block_for_inode(inode, b)
             data += self.read_block(phys)
         return bytes(data[:inode['size']])
@@ -474,7 +776,7 @@ class DiskImage:
         de_ddot = struct.pack(DIRENTRY_FMT, parent, 1, 2, b'\x00\x00',
                               b'..'.ljust(IPO_FS_MAX_NAME, b'\x00'))
 
-        buf = bytearray(BLOCK_SIZE)
+        buf = bytearray(self.block_size)
         buf[0:len(de_dot)] = de_dot
         buf[len(de_dot):len(de_dot) + len(de_ddot)] = de_ddot
         self.write_block(block, bytes(buf))
@@ -496,13 +798,7 @@ class DiskImage:
             self.write_inode(ino, inode)
             self.dir_add_entry(parent, name, ino, 2)
         inode = self.read_inode(ino)
-        data = text.encode()
-        inode['size'] = len(data)
-        for i in range((len(data) + BLOCK_SIZE - 1) // BLOCK_SIZE):
-            phys = self.get_block_for_inode(inode, i, alloc=True)
-            chunk = data[i * BLOCK_SIZE:(i + 1) * BLOCK_SIZE].ljust(BLOCK_SIZE, b'\x00')
-            self.write_block(phys, chunk)
-        self.write_inode(ino, inode)
+        self._write_file_data(ino, inode, text.encode())
 
     def put(self, localpath, destpath):
         """Copy a local host file into `destpath` on the IPO_FS image."""
@@ -552,41 +848,7 @@ class DiskImage:
             target = ino
 
         inode = self.read_inode(target)
-
-        # free existing data blocks
-        nblocks = (inode['size'] + BLOCK_SIZE - 1) // BLOCK_SIZE if inode['size'] > 0 else 0
-        for i in range(min(IPO_FS_DIRECT_BLOCKS, nblocks)):
-            if inode['direct'][i]:
-                self.bitmap_set(self.sb['block_bitmap_start'], inode['direct'][i] - self.sb['data_blocks_start'], 0)
-                inode['direct'][i] = 0
-
-        # free indirect blocks
-        if inode['indirect']:
-            ibuf = self.read_block(inode['indirect'])
-            for j in range(0, BLOCK_SIZE, 4):
-                ptr = struct.unpack('<I', ibuf[j:j+4])[0]
-                if ptr:
-                    self.bitmap_set(self.sb['block_bitmap_start'], ptr - self.sb['data_blocks_start'], 0)
-            # free the indirect block itself
-            self.bitmap_set(self.sb['block_bitmap_start'], inode['indirect'] - self.sb['data_blocks_start'], 0)
-            inode['indirect'] = 0
-
-        inode['size'] = 0
-        self.write_inode(target, inode)
-
-        # write new data
-        size = len(data)
-        written = 0
-        for i in range((size + BLOCK_SIZE - 1) // BLOCK_SIZE if size > 0 else 0):
-            phys = self.get_block_for_inode(inode, i, alloc=True)
-            chunk = data[i * BLOCK_SIZE:(i + 1) * BLOCK_SIZE]
-            if len(chunk) < BLOCK_SIZE:
-                chunk = chunk.ljust(BLOCK_SIZE, b'\x00')
-            self.write_block(phys, chunk)
-            written += len(chunk)
-
-        inode['size'] = size
-        self.write_inode(target, inode)
+        self._write_file_data(target, inode, data)
         return True
 
     def delete(self, path):
@@ -602,46 +864,15 @@ class DiskImage:
         # protected flag (if set, don't delete)
         if inode['mode'] & 0x80000000:
             return False
-        # directory: allow only empty (only '.' and '..')
+        # directory: allow only empty (only '.' and '..'); the kernel
+        # leaves holes where entries were removed, so check live entries
         if inode['mode'] & 1:
-            if inode['size'] > (DIRENTRY_SIZE * 2):
+            if any(e['name'] not in ('.', '..') for e in self.dir_entries(inode)):
                 return False
         # remove dir entry from parent
         if not self.dir_remove_entry(parent, name):
             return False
-        # free direct blocks
-        nblocks = (inode['size'] + BLOCK_SIZE - 1) // BLOCK_SIZE if inode['size'] > 0 else 0
-        for i in range(min(IPO_FS_DIRECT_BLOCKS, nblocks)):
-            if inode['direct'][i]:
-                self.bitmap_set(self.sb['block_bitmap_start'], inode['direct'][i] - self.sb['data_blocks_start'], 0)
-                inode['direct'][i] = 0
-        # free indirect
-        if inode['indirect']:
-            ibuf = self.read_block(inode['indirect'])
-            for j in range(0, BLOCK_SIZE, 4):
-                ptr = struct.unpack('<I', ibuf[j:j+4])[0]
-                if ptr:
-                    self.bitmap_set(self.sb['block_bitmap_start'], ptr - self.sb['data_blocks_start'], 0)
-            # free the indirect block itself
-            self.bitmap_set(self.sb['block_bitmap_start'], inode['indirect'] - self.sb['data_blocks_start'], 0)
-            inode['indirect'] = 0
-        # free double indirect
-        if inode['double_indirect']:
-            dibuf = self.read_block(inode['double_indirect'])
-            for di in range(0, BLOCK_SIZE, 4):
-                si_ptr = struct.unpack('<I', dibuf[di:di+4])[0]
-                if si_ptr:
-                    # Free blocks in single indirect block
-                    sibuf = self.read_block(si_ptr)
-                    for si in range(0, BLOCK_SIZE, 4):
-                        ptr = struct.unpack('<I', sibuf[si:si+4])[0]
-                        if ptr:
-                            self.bitmap_set(self.sb['block_bitmap_start'], ptr - self.sb['data_blocks_start'], 0)
-                    # Free the single indirect block
-                    self.bitmap_set(self.sb['block_bitmap_start'], si_ptr - self.sb['data_blocks_start'], 0)
-            # Free the double indirect block itself
-            self.bitmap_set(self.sb['block_bitmap_start'], inode['double_indirect'] - self.sb['data_blocks_start'], 0)
-            inode['double_indirect'] = 0
+        self._free_data(inode)
         # clear inode bitmap
         self.bitmap_set(self.sb['inode_bitmap_start'], ino-1, 0)
         # zero the inode on disk
@@ -656,7 +887,8 @@ def main():
     p.add_argument('-i', '--image', default='build/disk.img')
     p.add_argument('-s', '--start-lba', type=int, default=2048)
     sub = p.add_subparsers(dest='cmd')
-    sub.add_parser('format')
+    p_format = sub.add_parser('format')
+    p_format.add_argument('-b', '--block-size', type=int, default=DEFAULT_BLOCK_SIZE)
     sub.add_parser('ls').add_argument('path', nargs='?', default='/')
     sub.add_parser('cat').add_argument('path')
     sub.add_parser('mkdir').add_argument('path')
@@ -674,7 +906,7 @@ def main():
     d = DiskImage(args.image, args.start_lba, require_format=require_format)
 
     if args.cmd == 'format':
-        d.format_disk()
+        d.format_disk(block_size=args.block_size)
     elif args.cmd == 'ls':
         for n, t in d.ls(args.path):
             print(n + ('/' if t & 1 else ''))
@@ -0,0 +1,96 @@
+bits 32
+section .text
+
+global cpu_cpuid
+global cpu_wrmsr
+global cpu_rdtsc
+global cpu_irq_save
+global cpu_irq_restore
+global cpu_irq_enable
+global cpu_read_cr0
+global cpu_write_cr0
+global cpu_read_cr4
+global cpu_write_cr4
+global cpu_fxsave
+global cpu_fxrstor
+
+; void cpu_cpuid(uint32_t leaf, uint32_t regs[4])
+cpu_cpuid:
+    push ebx
+    push edi
+    mov eax, [esp + 12]     ; leaf
+    mov edi, [esp + 16]     ; regs
+    xor ecx, ecx
+    cpuid
+    mov [edi], eax
+    mov [edi + 4], ebx
+    mov [edi + 8], ecx
+    mov [edi + 12], edx
+    pop edi
+    pop ebx
+    ret
+
+; void cpu_wrmsr(uint32_t msr, uint32_t low, uint32_t high)
+cpu_wrmsr:
+    mov ecx, [esp + 4]
+    mov eax, [esp + 8]
+    mov edx, [esp + 12]
+    wrmsr
+    ret
+
+; uint64_t cpu_rdtsc(void)
+cpu_rdtsc:
+    rdtsc                   ; edx:eax is the 64-bit return value
+    ret
+
+; uint32_t cpu_irq_save(void)
+cpu_irq_save:
+    pushfd
+    pop eax
+    cli
+    ret
+
+; void cpu_irq_restore(uint32_t flags)
+cpu_irq_restore:
+    push dword [esp + 4]
+    popfd
+    ret
+
+; void cpu_irq_enable(void)
+cpu_irq_enable:
+    sti
+    ret
+
+; uint32_t cpu_read_cr0(void)
+cpu_read_cr0:
+    mov eax, cr0
+    ret
+
+; void cpu_write_cr0(uint32_t value)
+cpu_write_cr0:
+    mov eax, [esp + 4]
+    mov cr0, eax
+    ret
+
+; uint32_t cpu_read_cr4(void)
+cpu_read_cr4:
+    mov eax, cr4
+    ret
+
+; void cpu_write_cr4(uint32_t value)
+cpu_write_cr4:
+    mov eax, [esp + 4]
+    mov cr4, eax
+    ret
+
+; void cpu_fxsave(void *area)
+cpu_fxsave:
+    mov eax, [esp + 4]
+    fxsave [eax]
+    ret
+
+; void cpu_fxrstor(const void *area)
+cpu_fxrstor:
+    mov eax, [esp + 4]
+    fxrstor [eax]
+    ret
@@ -0,0 +1,32 @@
+bits 32
+section .text
+
+global gdt_flush
+global tss_flush
+global idt_flush
+
+; void gdt_flush(const void *gdt_ptr)
+gdt_flush:
+    mov eax, [esp + 4]
+    lgdt [eax]
+    mov ax, 0x10            ; kernel data
+    mov ds, ax
+    mov es, ax
+    mov fs, ax
+    mov gs, ax
+    mov ss, ax
+    jmp 0x08:.reload_cs     ; kernel code
+.reload_cs:
+    ret
+
+; void tss_flush(uint16_t selector)
+tss_flush:
+    mov eax, [esp + 4]
+    ltr ax
+    ret
+
+; void idt_flush(const void *idt_ptr)
+idt_flush:
+    mov eax, [esp + 4]
+    lidt [eax]
+    ret
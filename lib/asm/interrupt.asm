@@ -0,0 +1,105 @@
+bits 32
+section .text
+
+global isr_stub_table
+global irq_stub_table
+extern interrupt_dispatch
+
+; Exceptions without an error code push a dummy one so every frame has the same layout
+%macro ISR_NOERR 1
+isr%1:
+    push dword 0
+    push dword %1
+    jmp isr_common
+%endmacro
+
+%macro ISR_ERR 1
+isr%1:
+    push dword %1
+    jmp isr_common
+%endmacro
+
+ISR_NOERR 0
+ISR_NOERR 1
+ISR_NOERR 2
+ISR_NOERR 3
+ISR_NOERR 4
+ISR_NOERR 5
+ISR_NOERR 6
+ISR_NOERR 7
+ISR_ERR   8
+ISR_NOERR 9
+ISR_ERR   10
+ISR_ERR   11
+ISR_ERR   12
+ISR_ERR   13
+ISR_ERR   14
+ISR_NOERR 15
+ISR_NOERR 16
+ISR_ERR   17
+ISR_NOERR 18
+ISR_NOERR 19
+ISR_NOERR 20
+ISR_ERR   21
+ISR_NOERR 22
+ISR_NOERR 23
+ISR_NOERR 24
+ISR_NOERR 25
+ISR_NOERR 26
+ISR_NOERR 27
+ISR_NOERR 28
+ISR_ERR   29
+ISR_ERR   30
+ISR_NOERR 31
+
+; Hardware interrupts 0-15, remapped to vectors 32-47
+%assign i 0
+%rep 16
+irq%[i]:
+    push dword 0
+    push dword 32 + i
+    jmp isr_common
+%assign i i + 1
+%endrep
+
+; Builds an interrupt_frame_t on the stack and calls interrupt_dispatch(frame)
+isr_common:
+    pusha
+    push ds
+    push es
+    push fs
+    push gs
+    cld                     ; C code assumes DF=0; memmove may have been mid-copy
+
+    mov ax, 0x10            ; kernel data
+    mov ds, ax
+    mov es, ax
+    mov fs, ax
+    mov gs, ax
+
+    push esp
+    call interrupt_dispatch
+    add esp, 4
+
+    pop gs
+    pop fs
+    pop es
+    pop ds
+    popa
+    add esp, 8              ; int_no + err_code
+    iretd
+
+section .rodata
+isr_stub_table:
+%assign i 0
+%rep 32
+    dd isr%[i]
+%assign i i + 1
+%endrep
+
+irq_stub_table:
+%assign i 0
+%rep 16
+    dd irq%[i]
+%assign i i + 1
+%endrep
@@ -0,0 +1,110 @@
+bits 32
+section .text
+
+global syscall_int80_entry
+global syscall_sysenter_entry
+global user_exit_trampoline
+global user_mode_enter
+global user_mode_leave
+
+extern syscall_dispatch
+extern syscall_set_kernel_stack
+
+%define SYS_EXIT 0
+
+; int 0x80 entry. The user data segments stay loaded: they are flat and
+; usable from ring 0, so reloading them would only add latency.
+syscall_int80_entry:
+    cld
+    push ecx
+    push edx
+    push esi                ; arg4
+    push edx                ; arg3
+    push ecx                ; arg2
+    push ebx                ; arg1
+    push eax                ; number
+    call syscall_dispatch
+    add esp, 20
+    pop edx
+    pop ecx
+    iretd
+
+; SYSENTER entry: esp comes from MSR_SYSENTER_ESP, ecx/edx hold the
+; user stack and return address for SYSEXIT.
+syscall_sysenter_entry:
+    cld
+    push ecx                ; user esp
+    push edx                ; user eip
+    push ebp                ; arg4
+    push edi                ; arg3
+    push esi                ; arg2
+    push ebx                ; arg1
+    push eax                ; number
+    call syscall_dispatch
+    add esp, 20
+    pop edx
+    pop ecx
+    sti                     ; SYSENTER cleared IF; takes effect after sysexit
+    sysexit
+
+; main() of a ring 3 process returns here with its exit code in eax
+user_exit_trampoline:
+    mov ebx, eax
+    mov eax, SYS_EXIT
+    int 0x80
+.hang:
+    jmp .hang
+
+; int user_mode_enter(uint32_t entry, uint32_t user_esp, user_context_t *ctx)
+user_mode_enter:
+    push ebp
+    push ebx
+    push esi
+    push edi
+    pushfd                  ; kernel IF, restored by user_mode_leave
+
+    mov edx, [esp + 32]     ; ctx
+    mov [edx], esp          ; ctx->kernel_esp
+
+    ; Traps from ring 3 land just below this frame
+    mov ebx, esp
+    push ebx
+    call syscall_set_kernel_stack
+    add esp, 4
+
+    mov eax, [ebx + 24]     ; entry
+    mov ecx, [ebx + 28]     ; user esp
+
+    push dword 0x23         ; ss: user data | RPL 3
+    push ecx                ; esp
+    pushfd
+    and dword [esp], ~0x3000 ; IOPL 0: no port I/O from ring 3
+    or dword [esp], 0x200   ; IRQs stay live while the process runs
+    push dword 0x1B         ; cs: user code | RPL 3
+    push eax                ; eip
+
+    mov ax, 0x23
+    mov ds, ax
+    mov es, ax
+    mov fs, ax
+    mov gs, ax
+    iretd
+
+; void user_mode_leave(user_context_t *ctx, int exit_code)
+user_mode_leave:
+    mov eax, [esp + 8]      ; exit code
+    mov edx, [esp + 4]      ; ctx
+    mov esp, [edx]          ; back onto the frame saved by user_mode_enter
+
+    mov cx, 0x10
+    mov ds, cx
+    mov es, cx
+    mov fs, cx
+    mov gs, cx
+
+    popfd                   ; syscalls and faults arrive here with IF clear
+    pop edi
+    pop esi
+    pop ebx
+    pop ebp
+    ret
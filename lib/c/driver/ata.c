@@ -1,6 +1,7 @@
 #include <driver/ata/ata.h>
 #include <ioport.h>
 #include <stdio.h>
+#include <kernel/log.h>
 #include <string.h>
 #include <stdbool.h>
 #include <stdint.h>
@@ -31,6 +32,8 @@ static uint8_t ata_device_count = 0;
 
 static uint16_t identify_buf[256];
 
+static ata_io_stats_t ata_stats;
+
 /* -------------------------------------------------- */
 
 static void ata_io_wait(void) {
@@ -51,12 +54,12 @@ static bool ata_wait_bsy_clear(uint16_t base) {
 static bool ata_wait_drq(uint16_t base) {
     for (int i = 0; i < 100000; i++) {
         uint8_t st = inb(base + ATA_REG_STATUS);
-        if (st & ATA_SR_ERR) { printf("ata_wait_drq: ERR status=%u\n", (unsigned)st); return false; }
+        if (st & ATA_SR_ERR) { LOG_ERR(LOG_ATA, "ata_wait_drq: ERR status=%u\n", (unsigned)st); return false; }
         if (st & ATA_SR_DRQ) return true;
         ata_io_wait();
     }
     uint8_t st = inb(base + ATA_REG_STATUS);
-    printf("ata_wait_drq: timeout status=%u\n", (unsigned)st);
+    LOG_ERR(LOG_ATA, "ata_wait_drq: timeout status=%u\n", (unsigned)st);
     return false;
 }
 
@@ -135,12 +138,12 @@ static bool ata_identify(uint8_t drive) {
 void ata_init(void) {
     ata_device_count = 0;
 
-    printf("ATA: scanning primary channel...\n");
+    LOG_INFO(LOG_ATA, "ATA: scanning primary channel...\n");
 
     ata_identify(0); /* primary master */
     ata_identify(1); /* primary slave */
 
-    printf("ATA: found %d device(s)\n", ata_device_count);
+    LOG_INFO(LOG_ATA, "ATA: found %d device(s)\n", ata_device_count);
 }
 
 uint8_t ata_get_device_count(void) {
@@ -183,7 +186,7 @@ bool ata_read_sectors_lba28(uint32_t lba, uint8_t count, void *buf) {
     outb(base + ATA_REG_LBA1, (uint8_t)((lba >> 8) & 0xFF));
     outb(base + ATA_REG_LBA2, (uint8_t)((lba >> 16) & 0xFF));
 
-    if (!ata_wait_bsy_clear(base)) { printf("ata_read_sectors_lba28: device bsy not cleared\n"); return false; }
+    if (!ata_wait_bsy_clear(base)) { LOG_ERR(LOG_ATA, "ata_read_sectors_lba28: device bsy not cleared\n"); return false; }
 
     /* READ PIO */
     outb(base + ATA_REG_COMMAND, 0x20);
@@ -197,6 +200,8 @@ bool ata_read_sectors_lba28(uint32_t lba, uint8_t count, void *buf) {
         wptr += 256;
     }
 
+    ata_stats.read_commands++;
+    ata_stats.sectors_read += count;
     return true;
 }
 
@@ -217,7 +222,7 @@ bool ata_write_sectors_lba28(uint32_t lba, uint8_t count, const void *buf) {
     outb(base + ATA_REG_LBA2, (uint8_t)((lba >> 16) & 0xFF));
 
     /* Ensure device is ready */
-    if (!ata_wait_bsy_clear(base)) { printf("ata_write_sectors_lba28: device bsy not cleared\n"); return false; }
+    if (!ata_wait_bsy_clear(base)) { LOG_ERR(LOG_ATA, "ata_write_sectors_lba28: device bsy not cleared\n"); return false; }
 
     /* WRITE PIO */
     outb(base + ATA_REG_COMMAND, 0x30);
@@ -228,7 +233,7 @@ bool ata_write_sectors_lba28(uint32_t lba, uint8_t count, const void *buf) {
             /* small retry attempts */
             int retry = 0;
             while (retry < 5 && !ata_wait_drq(base)) { ata_io_wait(); retry++; }
-            if (retry == 5) { printf("ata_write_sectors_lba28: ata_wait_drq failed for sector %d after retries\n", s); return false; }
+            if (retry == 5) { LOG_ERR(LOG_ATA, "ata_write_sectors_lba28: ata_wait_drq failed for sector %d after retries\n", s); return false; }
         }
         for (int i = 0; i < 256; i++) {
             outw(base + ATA_REG_DATA, wptr[i]);
@@ -240,9 +245,15 @@ bool ata_write_sectors_lba28(uint32_t lba, uint8_t count, const void *buf) {
     /* flush cache */
     outb(base + ATA_REG_COMMAND, 0xE7);
     ata_io_wait();
-    if (!ata_wait_bsy_clear(base)) { printf("ata_write_sectors_lba28: flush bsy not cleared\n"); return false; }
+    if (!ata_wait_bsy_clear(base)) { LOG_ERR(LOG_ATA, "ata_write_sectors_lba28: flush bsy not cleared\n"); return false; }
     uint8_t st = inb(base + ATA_REG_STATUS);
-    if (st & ATA_SR_ERR) { printf("ata_write_sectors_lba28: status error after flush=%u\n", (unsigned)st); return false; }
+    if (st & ATA_SR_ERR) { LOG_ERR(LOG_ATA, "ata_write_sectors_lba28: status error after flush=%u\n", (unsigned)st); return false; }
 
+    ata_stats.write_commands++;
+    ata_stats.sectors_written += count;
     return true;
 }
+
+void ata_get_io_stats(ata_io_stats_t *out) {
+    if (out) *out = ata_stats;
+}
@@ -0,0 +1,98 @@
+#include <driver/serial.h>
+#include <system/cpu.h>
+#include <system/idt.h>
+#include <system/pic.h>
+#include <stdio.h>
+#include <ioport.h>
+
+static char tx_ring[SERIAL_TX_RING];
+static volatile uint32_t tx_head;   // next byte to send
+static volatile uint32_t tx_count;
+static uint32_t tx_dropped;
+static int serial_ready;
+
+static inline int thr_empty(void) {
+    return inb(SERIAL_COM1 + SERIAL_LSR) & SERIAL_LSR_THRE;
+}
+
+/* Move up to one FIFO's worth from the ring; caller holds interrupts off */
+static void tx_fill_fifo(void) {
+    if (thr_empty()) {
+        for (int i = 0; i < SERIAL_FIFO_DEPTH && tx_count; i++) {
+            outb(SERIAL_COM1 + SERIAL_DATA, (uint8_t)tx_ring[tx_head]);
+            tx_head = (tx_head + 1) % SERIAL_TX_RING;
+            tx_count--;
+        }
+    }
+    
+    // THRE only needs to fire while there is something left to send; a
+    // busy FIFO still needs it armed, or the queued bytes wait for the next write
+    outb(SERIAL_COM1 + SERIAL_IER, tx_count ? SERIAL_IER_THRE : 0);
+}
+
+static void serial_irq_handler(interrupt_frame_t *frame) {
+    (void)frame;
+    tx_fill_fifo();
+}
+
+void serial_init(void) {
+    outb(SERIAL_COM1 + SERIAL_IER, 0x00);
+    outb(SERIAL_COM1 + SERIAL_LCR, 0x80);               // DLAB on
+    outb(SERIAL_COM1 + SERIAL_DATA, SERIAL_DIVISOR & 0xFF);
+    outb(SERIAL_COM1 + SERIAL_IER, SERIAL_DIVISOR >> 8);
+    outb(SERIAL_COM1 + SERIAL_LCR, 0x03);               // 8N1, DLAB off
+    outb(SERIAL_COM1 + SERIAL_FCR, 0xC7);               // FIFOs on, cleared, 14-byte RX trigger
+    outb(SERIAL_COM1 + SERIAL_MCR, 0x0B);               // DTR, RTS, OUT2 (routes the IRQ)
+    
+    tx_head = 0;
+    tx_count = 0;
+    tx_dropped = 0;
+    
+    idt_register_handler(PIC_IRQ_BASE + IRQ_COM1, serial_irq_handler);
+    pic_enable_irq(IRQ_COM1);
+    serial_ready = 1;
+}
+
+void serial_write(const char *buf, size_t len) {
+    if (!serial_ready) {
+        for (size_t i = 0; i < len; i++) {
+            while (!thr_empty()) {}
+            outb(SERIAL_COM1 + SERIAL_DATA, (uint8_t)buf[i]);
+        }
+        return;
+    }
+    
+    uint32_t flags = cpu_irq_save();
+    
+    // Never wait for the line: what does not fit is counted and dropped
+    size_t space = SERIAL_TX_RING - tx_count;
+    if (len > space) {
+        tx_dropped += len - space;
+        len = space;
+    }
+    
+    uint32_t tail = (tx_head + tx_count) % SERIAL_TX_RING;
+    for (size_t i = 0; i < len; i++) {
+        tx_ring[tail] = buf[i];
+        tail = (tail + 1) % SERIAL_TX_RING;
+    }
+    tx_count += len;
+    
+    tx_fill_fifo();
+    cpu_irq_restore(flags);
+}
+
+void serial_flush(void) {
+    if (!serial_ready) return;
+    
+    // Polled so it also works with interrupts off (panic path)
+    while (tx_count) {
+        uint32_t flags = cpu_irq_save();
+        tx_fill_fifo();
+        cpu_irq_restore(flags);
+    }
+}
+
+uint32_t serial_get_dropped(void) {
+    return tx_dropped;
+}
@@ -1,14 +1,15 @@
 #include <file_system/ipo_fs.h>
 #include <string.h>
 #include <stdio.h>
+#include <kernel/log.h>
 #include <ioport.h>
 
 /* Reads a bit from the bitmap. bitmap_start is the block where the bitmap starts, bit_index is the bit index */
 bool bitmap_get(uint32_t bitmap_start, uint32_t bit_index) {
-    uint8_t buf[IPO_FS_BLOCK_SIZE];
+    uint8_t buf[IPO_FS_MAX_BLOCK_SIZE];
     uint32_t byte_index = bit_index / 8;
-    uint32_t block_offset = byte_index / IPO_FS_BLOCK_SIZE;
-    uint32_t inblock = byte_index % IPO_FS_BLOCK_SIZE;
+    uint32_t block_offset = byte_index / sb.block_size;
+    uint32_t inblock = byte_index % sb.block_size;
     int tries = 0;
     uint32_t lba = bitmap_start + block_offset;
     while (tries < 5) {
@@ -22,10 +23,10 @@ bool bitmap_get(uint32_t bitmap_start, uint32_t bit_index) {
 
 /* Set/clear bit */
 bool bitmap_set(uint32_t bitmap_start, uint32_t bit_index, bool value) {
-    uint8_t buf[IPO_FS_BLOCK_SIZE];
+    uint8_t buf[IPO_FS_MAX_BLOCK_SIZE];
     uint32_t byte_index = bit_index / 8;
-    uint32_t block_offset = byte_index / IPO_FS_BLOCK_SIZE;
-    uint32_t inblock = byte_index % IPO_FS_BLOCK_SIZE;
+    uint32_t block_offset = byte_index / sb.block_size;
+    uint32_t inblock = byte_index % sb.block_size;
     uint32_t lba = bitmap_start + block_offset;
     int tries = 0;
     while (tries < 5) {
@@ -33,7 +34,7 @@ bool bitmap_set(uint32_t bitmap_start, uint32_t bit_index, bool value) {
         for (volatile int __t = 0; __t < 1000; __t++) inb(0x80);
         tries++;
     }
-    if (tries == 5) { printf("bitmap_set: block_read failed lba=%u after retries\n", lba); return false; }
+    if (tries == 5) { LOG_ERR(LOG_FS, "bitmap_set: block_read failed lba=%u after retries\n", lba); return false; }
     if (value)
         buf[inblock] |= (1 << (bit_index & 7));
     else
@@ -44,6 +45,70 @@ bool bitmap_set(uint32_t bitmap_start, uint32_t bit_index, bool value) {
         for (volatile int __t = 0; __t < 1000; __t++) inb(0x80);
         tries++;
     }
-    if (tries == 5) { printf("bitmap_set: block_write failed lba=%u after retries\n", lba); return false; }
+    if (tries == 5) { LOG_ERR(LOG_FS, "bitmap_set: block_write failed lba=%u after retries\n", lba); return false; }
     return true;
 }
+
+/*
+ * Finds a clear bit among the first bit_count, searching from hint and
+ * wrapping around. Reads each bitmap block once and skips full bytes.
+ * Returns the bit index or -1 if every bit is set.
+ */
+int bitmap_find_free(uint32_t bitmap_start, uint32_t bit_count, uint32_t hint) {
+    uint8_t buf[IPO_FS_MAX_BLOCK_SIZE];
+    const uint32_t bits_per_block = sb.block_size * 8;
+    if (bit_count == 0) return -1;
+    if (hint >= bit_count) hint = 0;
+
+    uint32_t blocks = (bit_count + bits_per_block - 1) / bits_per_block;
+    uint32_t first = hint / bits_per_block;
+    for (uint32_t n = 0; n <= blocks; n++) {
+        uint32_t block = (first + n) % blocks;
+        if (!block_read(bitmap_start + block, buf)) return -1;
+        /* the hint's own block is scanned from the hint, then again from 0 on wrap */
+        uint32_t bit = (n == 0) ? hint % bits_per_block : 0;
+        for (; bit < bits_per_block; bit++) {
+            uint32_t index = block * bits_per_block + bit;
+            if (index >= bit_count) break;
+            uint8_t byte = buf[bit / 8];
+            if (byte == 0xFF) { bit |= 7; continue; }
+            if (((byte >> (bit & 7)) & 1) == 0) return (int)index;
+        }
+    }
+    return -1;
+}
+
+/*
+ * Finds run_len consecutive clear bits among the first bit_count, first
+ * from hint to the end, then from 0. Returns the first bit of the run or
+ * -1 if there is none.
+ */
+int bitmap_find_free_run(uint32_t bitmap_start, uint32_t bit_count, uint32_t run_len, uint32_t hint) {
+    uint8_t buf[IPO_FS_MAX_BLOCK_SIZE];
+    const uint32_t bits_per_block = sb.block_size * 8;
+    if (run_len == 0 || run_len > bit_count) return -1;
+    if (hint >= bit_count) hint = 0;
+
+    for (int pass = 0; pass < 2; pass++) {
+        uint32_t bit = pass == 0 ? hint : 0;
+        uint32_t end = pass == 0 ? bit_count : hint + run_len - 1;
+        if (end > bit_count) end = bit_count;
+        uint32_t run = 0;
+        bool loaded = false;
+        uint32_t loaded_block = 0;
+        for (; bit < end; bit++) {
+            uint32_t block = bit / bits_per_block;
+            if (!loaded || block != loaded_block) {
+                if (!block_read(bitmap_start + block, buf)) return -1;
+                loaded = true;
+                loaded_block = block;
+            }
+            uint32_t off = bit % bits_per_block;
+            uint8_t byte = buf[off / 8];
+            if ((off & 7) == 0 && byte == 0xFF) { run = 0; bit += 7; continue; }
+            if ((byte >> (off & 7)) & 1) { run = 0; continue; }
+            if (++run == run_len) return (int)(bit + 1 - run_len);
+        }
+    }
+    return -1;
+}
@@ -1,14 +1,161 @@
 #include <file_system/ipo_fs.h>
 #include <driver/ata/ata.h>
+#include <kernel/log.h>
+#include <string.h>
 #include <ioport.h>
 
+#define SECTORS_PER_BLOCK (sb.block_size / IPO_FS_SECTOR_SIZE)
+
+/* Largest transfer handed to the drive in one command */
+#define SECTORS_PER_TRANSFER 128
+
+/* Source for the lazy init paths: one maximum-sized block of zeros */
+static const uint8_t zero_blocks[IPO_FS_MAX_BLOCK_SIZE];
+
+/* Moves count FS blocks, splitting into commands the drive accepts */
+static bool disk_read(uint32_t fs_block_index, uint32_t count, void *buffer) {
+    uint8_t *out = (uint8_t *)buffer;
+    uint32_t lba = fs_start_lba + fs_block_index * SECTORS_PER_BLOCK;
+    uint32_t sectors = count * SECTORS_PER_BLOCK;
+    while (sectors > 0) {
+        uint32_t n = sectors > SECTORS_PER_TRANSFER ? SECTORS_PER_TRANSFER : sectors;
+        if (!ata_read_sectors_lba28(lba, (uint8_t)n, out)) return false;
+        lba += n;
+        out += n * IPO_FS_SECTOR_SIZE;
+        sectors -= n;
+    }
+    return true;
+}
+
+static bool disk_write(uint32_t fs_block_index, uint32_t count, const void *buffer) {
+    const uint8_t *in = (const uint8_t *)buffer;
+    uint32_t lba = fs_start_lba + fs_block_index * SECTORS_PER_BLOCK;
+    uint32_t sectors = count * SECTORS_PER_BLOCK;
+    while (sectors > 0) {
+        uint32_t n = sectors > SECTORS_PER_TRANSFER ? SECTORS_PER_TRANSFER : sectors;
+        if (!ata_write_sectors_lba28(lba, (uint8_t)n, in)) return false;
+        lba += n;
+        in += n * IPO_FS_SECTOR_SIZE;
+        sectors -= n;
+    }
+    return true;
+}
+
+/*
+ * Lazy init: a metadata region is only zeroed up to its high-water mark.
+ * Blocks above the mark read as zeros without touching the disk; the
+ * first write above it zeroes the gap, persists the new mark and only
+ * then writes the block, so a crash never exposes stale disk contents.
+ */
+static uint32_t *lazy_region(uint32_t fs_block_index, uint32_t *start, uint32_t *length) {
+    if ((sb.features & IPO_FS_FEATURE_LAZY_INIT) == 0) return NULL;
+    if (fs_block_index < sb.inode_bitmap_start || fs_block_index >= sb.data_blocks_start) return NULL;
+
+    if (fs_block_index >= sb.inode_table_start) {
+        *start = sb.inode_table_start;
+        *length = sb.data_blocks_start - sb.inode_table_start;
+        return &sb.inode_table_init;
+    }
+    if (fs_block_index >= sb.block_bitmap_start) {
+        *start = sb.block_bitmap_start;
+        *length = sb.inode_table_start - sb.block_bitmap_start;
+        return &sb.block_bitmap_init;
+    }
+    *start = sb.inode_bitmap_start;
+    *length = sb.block_bitmap_start - sb.inode_bitmap_start;
+    return &sb.inode_bitmap_init;
+}
+
+/* Zeroes region blocks [*mark, upto) and records the new mark on disk */
+static bool lazy_zero(uint32_t start, uint32_t *mark, uint32_t upto) {
+    uint32_t batch = sizeof(zero_blocks) / sb.block_size;
+    while (*mark < upto) {
+        uint32_t n = upto - *mark;
+        if (n > batch) n = batch;
+        if (!disk_write(start + *mark, n, zero_blocks)) {
+            LOG_ERR(LOG_FS, "lazy_zero: write failed at block %u\n", start + *mark);
+            return false;
+        }
+        *mark += n;
+    }
+    return superblock_write();
+}
+
 /* Reads an FS block (index relative to FS start) into buffer */
 bool block_read(uint32_t fs_block_index, void *buffer) {
-    /* translate to LBA and read single sector-sized block */
-    return ata_read_sectors_lba28(fs_start_lba + fs_block_index, 1, buffer);
+    uint32_t start, length;
+    uint32_t *mark = lazy_region(fs_block_index, &start, &length);
+    if (mark && fs_block_index - start >= *mark) {
+        memset(buffer, 0, sb.block_size);
+        return true;
+    }
+    return disk_read(fs_block_index, 1, buffer);
 }
 
 /* Writes an FS block */
 bool block_write(uint32_t fs_block_index, const void *buffer) {
-    return ata_write_sectors_lba28(fs_start_lba + fs_block_index, 1, buffer);
+    uint32_t start, length;
+    uint32_t *mark = lazy_region(fs_block_index, &start, &length);
+    if (mark && fs_block_index - start >= *mark) {
+        if (!lazy_zero(start, mark, fs_block_index - start + 1)) return false;
+    }
+    return disk_write(fs_block_index, 1, buffer);
+}
+
+/* Reads count consecutive FS blocks, in as few ATA commands as possible */
+bool blocks_read(uint32_t fs_block_index, uint32_t count, void *buffer) {
+    uint8_t *out = (uint8_t *)buffer;
+    if (fs_block_index < sb.data_blocks_start) {
+        /* metadata may be lazily initialised: go through block_read */
+        for (uint32_t i = 0; i < count; i++) {
+            if (!block_read(fs_block_index + i, out + i * sb.block_size)) return false;
+        }
+        return true;
+    }
+    return disk_read(fs_block_index, count, out);
+}
+
+/* Writes count consecutive FS blocks */
+bool blocks_write(uint32_t fs_block_index, uint32_t count, const void *buffer) {
+    const uint8_t *in = (const uint8_t *)buffer;
+    if (fs_block_index < sb.data_blocks_start) {
+        for (uint32_t i = 0; i < count; i++) {
+            if (!block_write(fs_block_index + i, in + i * sb.block_size)) return false;
+        }
+        return true;
+    }
+    return disk_write(fs_block_index, count, in);
+}
+
+/* Writes the in-memory superblock to the first sector of block 0 */
+bool superblock_write(void) {
+    uint8_t buf[IPO_FS_SECTOR_SIZE];
+    memset(buf, 0, sizeof(buf));
+    memcpy(buf, &sb, sizeof(sb));
+    return ata_write_sectors_lba28(fs_start_lba, 1, buf);
+}
+
+/*
+ * Background part of lazy init: zeroes up to max_blocks of the first
+ * unfinished region. Clears the feature once every region is done.
+ * Returns true while work is left.
+ */
+bool ipo_fs_lazy_init_step(uint32_t max_blocks) {
+    if (!fs_mounted || (sb.features & IPO_FS_FEATURE_LAZY_INIT) == 0) return false;
+
+    uint32_t regions[] = { sb.inode_bitmap_start, sb.block_bitmap_start, sb.inode_table_start };
+    for (uint32_t i = 0; i < sizeof(regions) / sizeof(regions[0]); i++) {
+        uint32_t start, length;
+        uint32_t *mark = lazy_region(regions[i], &start, &length);
+        if (!mark || *mark >= length) continue;
+
+        uint32_t upto = *mark + max_blocks;
+        if (upto > length) upto = length;
+        return lazy_zero(start, mark, upto);
+    }
+
+    sb.features &= ~IPO_FS_FEATURE_LAZY_INIT;
+    LOG_INFO(LOG_FS, "lazy init complete\n");
+    superblock_write();
+    return false;
 }
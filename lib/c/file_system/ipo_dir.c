@@ -3,38 +3,105 @@
 #include <stdio.h>
 
 #define DIR_ENTRY_SIZE sizeof(struct ipo_dir_entry)
-#define DIR_ENTRIES_PER_BLOCK (IPO_FS_BLOCK_SIZE / DIR_ENTRY_SIZE)
+#define DIR_ENTRIES_PER_BLOCK (sb.block_size / DIR_ENTRY_SIZE)
+
+void dir_iter_begin(dir_iter_t *it, const struct ipo_inode *din) {
+    it->din = *din;
+    it->entries = din->size / DIR_ENTRY_SIZE;
+    it->next = 0;
+    it->index = 0;
+    it->block = 0;
+    it->entry = NULL;
+    it->failed = false;
+    it->indirect_loaded = false;
+}
+
+/* Maps a directory block, reading the single indirect block at most once */
+static int iter_map(dir_iter_t *it, uint32_t logical) {
+    uint32_t slot = logical - IPO_FS_DIRECT_BLOCKS;
+    if ((it->din.mode & IPO_INODE_FLAG_EXTENTS) || logical < IPO_FS_DIRECT_BLOCKS ||
+        slot >= sb.block_size / 4 || !it->din.indirect) {
+        return get_data_block_for_inode(&it->din, logical, false);
+    }
+    if (!it->indirect_loaded) {
+        if (!block_read(it->din.indirect, it->indirect)) return -1;
+        it->indirect_loaded = true;
+    }
+    uint32_t phys = ((uint32_t *)it->indirect)[slot];
+    return phys ? (int)phys : -1;
+}
+
+/* Advances to the next live entry; false at the end or on a read error */
+bool dir_iter_next(dir_iter_t *it) {
+    while (it->next < it->entries) {
+        uint32_t e = it->next++;
+        uint32_t inblock = e % DIR_ENTRIES_PER_BLOCK;
+        if (inblock == 0) {
+            int phys = iter_map(it, e / DIR_ENTRIES_PER_BLOCK);
+            if (phys <= 0) {
+                /* hole: skip the rest of the block */
+                it->block = 0;
+                it->next = (e / DIR_ENTRIES_PER_BLOCK + 1) * DIR_ENTRIES_PER_BLOCK;
+                continue;
+            }
+            if (!block_read(phys, it->buf)) {
+                it->failed = true;
+                break;
+            }
+            it->block = phys;
+        }
+        struct ipo_dir_entry *de = (struct ipo_dir_entry *)it->buf + inblock;
+        if (de->inode == 0) continue;
+        it->index = e;
+        it->entry = de;
+        return true;
+    }
+    it->entry = NULL;
+    return false;
+}
+
+/* True if din holds nothing but "." and ".." */
+bool dir_is_empty(const struct ipo_inode *din) {
+    dir_iter_t it;
+    dir_iter_begin(&it, din);
+    while (dir_iter_next(&it)) {
+        if (strcmp(it.entry->name, ".") != 0 && strcmp(it.entry->name, "..") != 0) return false;
+    }
+    return !it.failed;
+}
+
+bool dir_entry_matches(const struct ipo_dir_entry *de, const char *name) {
+    size_t dn = de->name_len ? de->name_len : strlen(de->name);
+    size_t nn = strlen(name);
+    return dn == nn && dn > 0 && strncmp(de->name, name, dn) == 0;
+}
 
 int dir_find_entry(uint32_t dir_inode_no, const char *name, struct ipo_dir_entry *out_entry, uint32_t *out_block, uint32_t *out_block_off) {
     struct ipo_inode din;
     if (!read_inode(dir_inode_no, &din)) return -1;
     if ((din.mode & IPO_INODE_TYPE_DIR) == 0) return -1;
-    uint32_t entries = (din.size) / DIR_ENTRY_SIZE;
-    uint8_t buf[IPO_FS_BLOCK_SIZE];
-    for (uint32_t e = 0; e < entries; e++) {
-        uint32_t block_idx = e / DIR_ENTRIES_PER_BLOCK;
-        uint32_t inblock = e % DIR_ENTRIES_PER_BLOCK;
-        int phys = -1;
-        if (block_idx < IPO_FS_DIRECT_BLOCKS)
-            phys = din.direct[block_idx];
-        else {
-            int tmp = get_data_block_for_inode(&din, block_idx, false);
-            if (tmp < 0) continue;
-            phys = tmp;
-        }
-        if (!phys) continue;
-        if (!block_read(phys, buf)) return -1;
-        struct ipo_dir_entry *de = (struct ipo_dir_entry *)buf + inblock;
-        if (de->inode != 0) {
-            size_t dn = de->name_len ? de->name_len : strlen(de->name);
-            size_t nn = strlen(name);
-            if (dn == nn && dn > 0 && strncmp(de->name, name, dn) == 0) {
-                if (out_entry) memcpy(out_entry, de, sizeof(*de));
-                if (out_block) *out_block = phys;
-                if (out_block_off) *out_block_off = inblock;
-                return 0;
-            }
+    if (dir_index_active(&din)) {
+        uint8_t buf[IPO_FS_MAX_BLOCK_SIZE];
+        uint32_t e, phys;
+        int r = dir_index_lookup(&din, name, &e, &phys, buf);
+        if (r == 0) {
+            struct ipo_dir_entry *de = (struct ipo_dir_entry *)buf + e % DIR_ENTRIES_PER_BLOCK;
+            if (out_entry) memcpy(out_entry, de, sizeof(*de));
+            if (out_block) *out_block = phys;
+            if (out_block_off) *out_block_off = e % DIR_ENTRIES_PER_BLOCK;
+            return 0;
         }
+        if (r == -1) return -1;
+        /* unreadable index: fall back to scanning */
+    }
+    dir_iter_t it;
+    dir_iter_begin(&it, &din);
+    while (dir_iter_next(&it)) {
+        if (!dir_entry_matches(it.entry, name)) continue;
+        if (out_entry) memcpy(out_entry, it.entry, sizeof(*it.entry));
+        if (out_block) *out_block = it.block;
+        if (out_block_off) *out_block_off = it.index % DIR_ENTRIES_PER_BLOCK;
+        return 0;
     }
     return -1;
 }
@@ -68,7 +135,7 @@ bool dir_add_entry(uint32_t dir_inode_no, const char *name, uint32_t inode_no, u
     uint32_t inblock = entries % DIR_ENTRIES_PER_BLOCK;
     int phys = get_data_block_for_inode(&din, block_idx, true);
     if (phys < 0) return false;
-    uint8_t buf[IPO_FS_BLOCK_SIZE];
+    uint8_t buf[IPO_FS_MAX_BLOCK_SIZE];
     if (!block_read(phys, buf)) return false;
     struct ipo_dir_entry *de = (struct ipo_dir_entry *)buf + inblock;
     de->inode = inode_no;
@@ -82,33 +149,48 @@ bool dir_add_entry(uint32_t dir_inode_no, const char *name, uint32_t inode_no, u
     de->name[de->name_len] = '\0';
     if (!block_write(phys, buf)) return false;
     din.size += DIR_ENTRY_SIZE;
+    dir_index_add(&din, de->name, entries);
     write_inode(dir_inode_no, &din);
     return true;
 }
 
+/* Clears entry e, held in buf as directory block phys */
+static bool remove_at(uint32_t dir_inode_no, struct ipo_inode *din, uint32_t e, uint32_t phys, uint8_t *buf) {
+    struct ipo_dir_entry *de = (struct ipo_dir_entry *)buf + e % DIR_ENTRIES_PER_BLOCK;
+    struct ipo_inode target_inode;
+    if (read_inode(de->inode, &target_inode)) {
+        if (target_inode.mode & IPO_INODE_FLAG_PROTECTED) return false;
+    }
+    if (strcmp(de->name, ".") == 0 || strcmp(de->name, "..") == 0) return false;
+    char name[IPO_FS_MAX_NAME];
+    memcpy(name, de->name, sizeof(name));
+    name[IPO_FS_MAX_NAME - 1] = '\0';
+    de->inode = 0;
+    de->name[0] = '\0';
+    de->name_len = 0;
+    if (!block_write(phys, buf)) return false;
+    if (dir_index_active(din)) {
+        dir_index_remove(din, name, e);
+        write_inode(dir_inode_no, din);
+    }
+    return true;
+}
+
 bool dir_remove_entry(uint32_t dir_inode_no, const char *name) {
     struct ipo_inode din;
     if (!read_inode(dir_inode_no, &din)) return false;
-    uint32_t entries = (din.size) / DIR_ENTRY_SIZE;
-    uint8_t buf[IPO_FS_BLOCK_SIZE];
-    for (uint32_t e = 0; e < entries; e++) {
-        uint32_t block_idx = e / DIR_ENTRIES_PER_BLOCK;
-        uint32_t inblock = e % DIR_ENTRIES_PER_BLOCK;
-        int phys = get_data_block_for_inode(&din, block_idx, false);
-        if (phys < 0) continue;
-        if (!block_read(phys, buf)) return false;
-        struct ipo_dir_entry *de = (struct ipo_dir_entry *)buf + inblock;
-        if (de->inode != 0 && strncmp(de->name, name, IPO_FS_MAX_NAME) == 0) {
-            struct ipo_inode target_inode;
-            if (read_inode(de->inode, &target_inode)) {
-                if (target_inode.mode & IPO_INODE_FLAG_PROTECTED) return false;
-            }
-            if (strcmp(de->name, ".") == 0 || strcmp(de->name, "..") == 0) return false;
-            de->inode = 0;
-            de->name[0] = '\0';
-            de->name_len = 0;
-            if (!block_write(phys, buf)) return false;
-            return true;
+    if (dir_index_active(&din)) {
+        uint8_t buf[IPO_FS_MAX_BLOCK_SIZE];
+        uint32_t e, phys;
+        int r = dir_index_lookup(&din, name, &e, &phys, buf);
+        if (r == 0) return remove_at(dir_inode_no, &din, e, phys, buf);
+        if (r == -1) return false;
+    }
+    dir_iter_t it;
+    dir_iter_begin(&it, &din);
+    while (dir_iter_next(&it)) {
+        if (strncmp(it.entry->name, name, IPO_FS_MAX_NAME) == 0) {
+            return remove_at(dir_inode_no, &din, it.index, it.block, it.buf);
         }
     }
     return false;
@@ -120,17 +202,12 @@ int ipo_fs_list_dir(const char *path, char *out, int out_size) {
     struct ipo_inode din;
     if (!read_inode(ino, &din)) return -1;
     if ((din.mode & IPO_INODE_TYPE_DIR) == 0) return -1;
-    uint32_t entries = din.size / DIR_ENTRY_SIZE;
-    uint8_t buf[IPO_FS_BLOCK_SIZE];
     int pos = 0;
-    for (uint32_t e = 0; e < entries; e++) {
-        uint32_t block_idx = e / DIR_ENTRIES_PER_BLOCK;
-        uint32_t inblock = e % DIR_ENTRIES_PER_BLOCK;
-        int phys = get_data_block_for_inode(&din, block_idx, false);
-        if (phys < 0) continue;
-        if (!block_read(phys, buf)) return -1;
-        struct ipo_dir_entry *de = (struct ipo_dir_entry *)buf + inblock;
-        if (de->inode == 0 || de->name_len == 0) continue;
+    dir_iter_t it;
+    dir_iter_begin(&it, &din);
+    while (dir_iter_next(&it)) {
+        struct ipo_dir_entry *de = it.entry;
+        if (de->name_len == 0) continue;
         int l = de->name_len;
         if (pos + l + 3 >= out_size) break;
         memcpy(out + pos, de->name, l);
@@ -138,6 +215,7 @@ int ipo_fs_list_dir(const char *path, char *out, int out_size) {
         if (de->type == IPO_INODE_TYPE_DIR) out[pos++] = '/';
         out[pos++] = '\n';
     }
+    if (it.failed) return -1;
     if (pos < out_size) out[pos] = '\0'; else out[out_size-1] = '\0';
     return pos;
 }
@@ -0,0 +1,205 @@
+#include <file_system/ipo_fs.h>
+#include <string.h>
+#include <kernel/log.h>
+
+#define DIR_ENTRY_SIZE sizeof(struct ipo_dir_entry)
+#define DIR_ENTRIES_PER_BLOCK (sb.block_size / DIR_ENTRY_SIZE)
+#define SLOTS_PER_BLOCK (sb.block_size / sizeof(struct ipo_dir_index_slot))
+
+/* Directories that fit in one block are scanned; larger ones are indexed */
+#define DIR_INDEX_MIN_ENTRIES DIR_ENTRIES_PER_BLOCK
+/* Largest table; directories beyond it fall back to the linear scan */
+#define DIR_INDEX_MAX_BLOCKS 256
+
+/* The table block being worked on; the FS is never re-entered, so one is enough */
+static struct {
+    uint8_t buf[IPO_FS_MAX_BLOCK_SIZE];
+    uint32_t block; /* 0: nothing loaded (block 0 holds the superblock) */
+    bool dirty;
+} table;
+
+/* FNV-1a */
+uint32_t dir_name_hash(const char *name, size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (uint8_t)name[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static uint32_t entry_hash(const struct ipo_dir_entry *de) {
+    size_t len = de->name_len;
+    if (len == 0) while (len < IPO_FS_MAX_NAME && de->name[len]) len++;
+    return dir_name_hash(de->name, len);
+}
+
+bool dir_index_active(const struct ipo_inode *din) {
+    return (sb.features & IPO_FS_FEATURE_DIR_INDEX) && din->index_blocks != 0;
+}
+
+static bool table_flush(void) {
+    if (!table.dirty) return true;
+    table.dirty = false;
+    return block_write(table.block, table.buf);
+}
+
+/* Returns slot number n of din's table, loading its block if needed */
+static struct ipo_dir_index_slot *table_slot(const struct ipo_inode *din, uint32_t n) {
+    uint32_t block = din->index_start + n / SLOTS_PER_BLOCK;
+    if (table.block != block) {
+        if (!table_flush()) return NULL;
+        if (!block_read(block, table.buf)) {
+            table.block = 0;
+            return NULL;
+        }
+        table.block = block;
+    }
+    return (struct ipo_dir_index_slot *)table.buf + n % SLOTS_PER_BLOCK;
+}
+
+/* Puts entry into the first free or deleted slot of its probe sequence */
+static bool table_insert(struct ipo_inode *din, uint32_t hash, uint32_t entry) {
+    uint32_t mask = din->index_blocks * SLOTS_PER_BLOCK - 1;
+    for (uint32_t n = 0, i = hash & mask; n <= mask; n++, i = (i + 1) & mask) {
+        struct ipo_dir_index_slot *slot = table_slot(din, i);
+        if (!slot) return false;
+        if (slot->entry != 0 && slot->entry != IPO_DIR_INDEX_DELETED) continue;
+        if (slot->entry == IPO_DIR_INDEX_DELETED) din->index_deleted--;
+        slot->hash = hash;
+        slot->entry = entry + 1;
+        table.dirty = true;
+        din->index_used++;
+        return true;
+    }
+    return false;
+}
+
+/* Releases the table and leaves din unindexed; the caller writes din back */
+void dir_index_free(struct ipo_inode *din) {
+    for (uint32_t i = 0; i < din->index_blocks; i++) free_block(din->index_start + i);
+    din->index_start = 0;
+    din->index_blocks = 0;
+    din->index_used = 0;
+    din->index_deleted = 0;
+}
+
+/*
+ * Builds a table with room for twice the directory's entries from one
+ * pass over its blocks, then replaces the old table with it.
+ */
+static bool rebuild(struct ipo_inode *din) {
+    uint32_t entries = din->size / DIR_ENTRY_SIZE;
+    uint32_t blocks = 1;
+    while (blocks * SLOTS_PER_BLOCK < 2 * (entries + 1)) blocks *= 2;
+    if (blocks > DIR_INDEX_MAX_BLOCKS) {
+        LOG_DEBUG(LOG_FS, "dir index: %u entries is too many, using linear lookups\n", entries);
+        return false;
+    }
+    int start = allocate_blocks(blocks);
+    if (start < 0) return false;
+
+    struct ipo_inode next = *din;
+    next.index_start = (uint32_t)start;
+    next.index_blocks = blocks;
+    next.index_used = 0;
+    next.index_deleted = 0;
+
+    dir_iter_t it;
+    dir_iter_begin(&it, din);
+    table.block = 0;
+    table.dirty = false;
+    while (dir_iter_next(&it)) {
+        if (!table_insert(&next, entry_hash(it.entry), it.index)) goto fail;
+    }
+    if (it.failed) goto fail;
+    if (!table_flush()) goto fail;
+
+    dir_index_free(din);
+    *din = next;
+    return true;
+
+fail:
+    LOG_ERR(LOG_FS, "dir index: rebuild failed\n");
+    table.block = 0;
+    table.dirty = false;
+    dir_index_free(&next);
+    return false;
+}
+
+/*
+ * Looks name up through the index. Returns 0 with the entry number, the
+ * directory block holding it and that block's contents in block_buf; -1
+ * if the directory has no such entry; -2 if the index could not be read
+ * and the caller should scan instead.
+ */
+int dir_index_lookup(struct ipo_inode *din, const char *name, uint32_t *out_entry_no, uint32_t *out_block, void *block_buf) {
+    uint32_t hash = dir_name_hash(name, strlen(name));
+    uint32_t mask = din->index_blocks * SLOTS_PER_BLOCK - 1;
+    table.block = 0;
+    table.dirty = false;
+    for (uint32_t n = 0, i = hash & mask; n <= mask; n++, i = (i + 1) & mask) {
+        struct ipo_dir_index_slot *slot = table_slot(din, i);
+        if (!slot) return -2;
+        if (slot->entry == 0) return -1;
+        if (slot->entry == IPO_DIR_INDEX_DELETED || slot->hash != hash) continue;
+
+        uint32_t e = slot->entry - 1;
+        int phys = get_data_block_for_inode(din, e / DIR_ENTRIES_PER_BLOCK, false);
+        if (phys < 0 || !block_read(phys, block_buf)) return -2;
+        const struct ipo_dir_entry *de = (const struct ipo_dir_entry *)block_buf + e % DIR_ENTRIES_PER_BLOCK;
+        if (de->inode == 0 || !dir_entry_matches(de, name)) continue;
+        *out_entry_no = e;
+        *out_block = phys;
+        return 0;
+    }
+    return -1;
+}
+
+/*
+ * Records that entry now holds name. Creates the index once the directory
+ * outgrows its first block and rebuilds it when it gets three quarters
+ * full. If that fails the index is dropped, which leaves lookups correct
+ * but linear. The caller has already grown din->size and writes din back.
+ */
+void dir_index_add(struct ipo_inode *din, const char *name, uint32_t entry) {
+    if ((sb.features & IPO_FS_FEATURE_DIR_INDEX) == 0) return;
+    if (din->index_blocks == 0) {
+        if (din->size / DIR_ENTRY_SIZE > DIR_INDEX_MIN_ENTRIES) rebuild(din);
+        return;
+    }
+
+    uint32_t capacity = din->index_blocks * SLOTS_PER_BLOCK;
+    if ((din->index_used + din->index_deleted + 1) * 4 > capacity * 3) {
+        if (!rebuild(din)) dir_index_free(din);
+        return;
+    }
+    table.block = 0;
+    table.dirty = false;
+    if (!table_insert(din, dir_name_hash(name, strlen(name)), entry) || !table_flush()) {
+        LOG_ERR(LOG_FS, "dir index: insert failed, dropping index\n");
+        dir_index_free(din);
+    }
+}
+
+/* Marks entry's slot deleted; the caller writes din back */
+void dir_index_remove(struct ipo_inode *din, const char *name, uint32_t entry) {
+    if (!dir_index_active(din)) return;
+    uint32_t hash = dir_name_hash(name, strlen(name));
+    uint32_t mask = din->index_blocks * SLOTS_PER_BLOCK - 1;
+    table.block = 0;
+    table.dirty = false;
+    for (uint32_t n = 0, i = hash & mask; n <= mask; n++, i = (i + 1) & mask) {
+        struct ipo_dir_index_slot *slot = table_slot(din, i);
+        if (!slot || slot->entry == 0) break;
+        if (slot->entry != entry + 1) continue;
+        slot->entry = IPO_DIR_INDEX_DELETED;
+        table.dirty = true;
+        din->index_used--;
+        din->index_deleted++;
+        if (table_flush()) return;
+        break;
+    }
+    LOG_ERR(LOG_FS, "dir index: entry %u not indexed, dropping index\n", entry);
+    dir_index_free(din);
+}
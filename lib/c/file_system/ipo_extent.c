@@ -0,0 +1,259 @@
+#include <file_system/ipo_fs.h>
+#include <string.h>
+#include <kernel/log.h>
+
+#define EXTENT_BLOCK_MAX ((sb.block_size - sizeof(struct ipo_extent_header)) / sizeof(struct ipo_extent))
+#define EXTENT_MAX_DEPTH 4
+
+/* One node on a root-to-leaf walk; block 0 means the root inside the inode */
+typedef struct {
+    uint32_t block;
+    uint32_t index; /* entry followed to the next level */
+    struct ipo_extent_header *hdr;
+    struct ipo_extent *ext;
+    uint8_t buf[IPO_FS_MAX_BLOCK_SIZE];
+} extent_level_t;
+
+/* The walk being modified; the FS is never re-entered, so one is enough */
+static extent_level_t path[EXTENT_MAX_DEPTH + 1];
+
+void extent_init(struct ipo_inode *inode) {
+    memset(&inode->extent_root, 0, sizeof(inode->extent_root) + sizeof(inode->extents));
+    inode->extent_root.magic = IPO_EXTENT_MAGIC;
+    inode->extent_root.max = IPO_EXTENT_ROOT_MAX;
+    inode->mode |= IPO_INODE_FLAG_EXTENTS;
+}
+
+/* Index of the last entry starting at or before logical, or -1 */
+static int find_entry(const struct ipo_extent_header *hdr, const struct ipo_extent *ext, uint32_t logical) {
+    int lo = 0, hi = (int)hdr->entries - 1, found = -1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (ext[mid].logical <= logical) {
+            found = mid;
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return found;
+}
+
+static bool load_node(extent_level_t *level, uint32_t block) {
+    level->block = block;
+    level->hdr = (struct ipo_extent_header *)level->buf;
+    level->ext = (struct ipo_extent *)(level->hdr + 1);
+    if (!block_read(block, level->buf)) return false;
+    if (level->hdr->magic != IPO_EXTENT_MAGIC) {
+        LOG_ERR(LOG_FS, "extent: bad node magic in block %u\n", block);
+        return false;
+    }
+    return true;
+}
+
+static bool store_node(const extent_level_t *level) {
+    if (level->block == 0) return true; /* root: written back with the inode */
+    return block_write(level->block, level->buf);
+}
+
+/* Fills path[0..depth] down to the leaf covering logical; returns the depth or -1 */
+static int walk(struct ipo_inode *inode, uint32_t logical) {
+    uint32_t depth = inode->extent_root.depth;
+    if (depth > EXTENT_MAX_DEPTH) return -1;
+
+    path[0].block = 0;
+    path[0].hdr = &inode->extent_root;
+    path[0].ext = inode->extents;
+    for (uint32_t d = 0; d < depth; d++) {
+        if (path[d].hdr->entries == 0) return -1;
+        int i = find_entry(path[d].hdr, path[d].ext, logical);
+        path[d].index = i < 0 ? 0 : (uint32_t)i;
+        if (!load_node(&path[d + 1], path[d].ext[path[d].index].physical)) return -1;
+    }
+    return (int)depth;
+}
+
+int extent_map(const struct ipo_inode *inode, uint32_t logical, uint32_t *out_run) {
+    uint8_t buf[IPO_FS_MAX_BLOCK_SIZE];
+    const struct ipo_extent_header *hdr = &inode->extent_root;
+    const struct ipo_extent *ext = inode->extents;
+    if (hdr->depth > EXTENT_MAX_DEPTH) return -1;
+
+    for (uint32_t d = hdr->depth; d > 0; d--) {
+        int i = find_entry(hdr, ext, logical);
+        if (i < 0) return -1;
+        if (!block_read(ext[i].physical, buf)) return -1;
+        hdr = (const struct ipo_extent_header *)buf;
+        ext = (const struct ipo_extent *)(hdr + 1);
+        if (hdr->magic != IPO_EXTENT_MAGIC) return -1;
+    }
+
+    int i = find_entry(hdr, ext, logical);
+    if (i < 0 || logical - ext[i].logical >= ext[i].length) return -1;
+    uint32_t offset = logical - ext[i].logical;
+    if (out_run) *out_run = ext[i].length - offset;
+    return (int)(ext[i].physical + offset);
+}
+
+/* After path[level] gained a new first entry, lowers the keys above it */
+static bool update_keys(int level, uint32_t key) {
+    for (; level > 0; level--) {
+        extent_level_t *parent = &path[level - 1];
+        parent->ext[parent->index].logical = key;
+        if (!store_node(parent)) return false;
+        if (parent->index != 0) break;
+    }
+    return true;
+}
+
+/* Moves the root's entries into a new node one level down */
+static bool grow_root(struct ipo_inode *inode) {
+    uint32_t depth = inode->extent_root.depth;
+    if (depth >= EXTENT_MAX_DEPTH) {
+        LOG_ERR(LOG_FS, "extent: tree too deep\n");
+        return false;
+    }
+    int block = allocate_block();
+    if (block < 0) return false;
+
+    /* shift the walk down to make room for the new level */
+    for (int d = (int)depth; d >= 1; d--) {
+        path[d + 1] = path[d];
+        path[d + 1].hdr = (struct ipo_extent_header *)path[d + 1].buf;
+        path[d + 1].ext = (struct ipo_extent *)(path[d + 1].hdr + 1);
+    }
+
+    extent_level_t *child = &path[1];
+    memset(child->buf, 0, sizeof(child->buf));
+    child->block = (uint32_t)block;
+    child->index = path[0].index;
+    child->hdr = (struct ipo_extent_header *)child->buf;
+    child->ext = (struct ipo_extent *)(child->hdr + 1);
+    *child->hdr = inode->extent_root;
+    child->hdr->max = EXTENT_BLOCK_MAX;
+    memcpy(child->ext, inode->extents, inode->extent_root.entries * sizeof(struct ipo_extent));
+    if (!store_node(child)) return false;
+
+    inode->extent_root.depth++;
+    inode->extent_root.entries = 1;
+    inode->extents[0].physical = (uint32_t)block;
+    inode->extents[0].length = 0;
+    path[0].index = 0;
+    return true;
+}
+
+/*
+ * Inserts entry into the node at path[level]. A full root grows the tree
+ * by one level; any other full node is split and the new right sibling
+ * is inserted into its parent.
+ */
+static bool insert_entry(struct ipo_inode *inode, int level, struct ipo_extent entry) {
+    extent_level_t *node = &path[level];
+
+    if (node->hdr->entries < node->hdr->max) {
+        int pos = find_entry(node->hdr, node->ext, entry.logical) + 1;
+        memmove(node->ext + pos + 1, node->ext + pos, (node->hdr->entries - pos) * sizeof(struct ipo_extent));
+        node->ext[pos] = entry;
+        node->hdr->entries++;
+        if (!store_node(node)) return false;
+        return pos == 0 ? update_keys(level, entry.logical) : true;
+    }
+
+    if (level == 0) {
+        if (!grow_root(inode)) return false;
+        return insert_entry(inode, 1, entry);
+    }
+
+    int right_block = allocate_block();
+    if (right_block < 0) return false;
+    extent_level_t right;
+    memset(right.buf, 0, sizeof(right.buf));
+    right.block = (uint32_t)right_block;
+    right.hdr = (struct ipo_extent_header *)right.buf;
+    right.ext = (struct ipo_extent *)(right.hdr + 1);
+
+    /* files grow at the end: an append leaves the left node full */
+    uint32_t keep = node->hdr->entries / 2;
+    if (entry.logical > node->ext[node->hdr->entries - 1].logical) keep = node->hdr->entries;
+    *right.hdr = *node->hdr;
+    right.hdr->entries = node->hdr->entries - keep;
+    memcpy(right.ext, node->ext + keep, right.hdr->entries * sizeof(struct ipo_extent));
+    node->hdr->entries = keep;
+
+    bool into_right = right.hdr->entries == 0 || entry.logical >= right.ext[0].logical;
+    extent_level_t *half = into_right ? &right : node;
+    int pos = find_entry(half->hdr, half->ext, entry.logical) + 1;
+    memmove(half->ext + pos + 1, half->ext + pos, (half->hdr->entries - pos) * sizeof(struct ipo_extent));
+    half->ext[pos] = entry;
+    half->hdr->entries++;
+
+    if (!store_node(&right) || !store_node(node)) return false;
+    if (!into_right && pos == 0 && !update_keys(level, entry.logical)) return false;
+
+    struct ipo_extent index = { right.ext[0].logical, right.block, 0 };
+    return insert_entry(inode, level - 1, index);
+}
+
+/*
+ * Maps logical, allocating a block if it is unmapped. The new block is
+ * taken right after the previous extent when possible, so sequential
+ * writes extend one extent instead of adding entries. It is zeroed
+ * only if zero is set.
+ */
+int extent_map_alloc(struct ipo_inode *inode, uint32_t logical, bool zero) {
+    int leaf = walk(inode, logical);
+    if (leaf < 0) return -1;
+    extent_level_t *node = &path[leaf];
+
+    int i = find_entry(node->hdr, node->ext, logical);
+    struct ipo_extent *prev = i >= 0 ? &node->ext[i] : NULL;
+    if (prev && logical - prev->logical < prev->length) {
+        return (int)(prev->physical + (logical - prev->logical));
+    }
+
+    uint32_t goal = prev ? prev->physical + (logical - prev->logical) : 0;
+    int block = allocate_block_near(goal, zero);
+    if (block < 0) return -1;
+
+    if (prev && prev->logical + prev->length == logical && prev->physical + prev->length == (uint32_t)block) {
+        prev->length++;
+        if (store_node(node)) return block;
+    } else {
+        struct ipo_extent entry = { logical, (uint32_t)block, 1 };
+        if (insert_entry(inode, leaf, entry)) return block;
+    }
+    free_block((uint32_t)block);
+    return -1;
+}
+
+/* Frees the data and child nodes referenced by the node loaded at path[level] */
+static bool free_node(int level) {
+    extent_level_t *node = &path[level];
+    bool ok = true;
+    for (uint32_t i = 0; i < node->hdr->entries; i++) {
+        const struct ipo_extent *e = &node->ext[i];
+        if (node->hdr->depth == 0) {
+            for (uint32_t b = 0; b < e->length; b++) {
+                ok &= free_block(e->physical + b);
+            }
+            continue;
+        }
+        if (level >= EXTENT_MAX_DEPTH || !load_node(&path[level + 1], e->physical)) {
+            ok = false;
+            continue;
+        }
+        ok &= free_node(level + 1);
+        ok &= free_block(e->physical);
+    }
+    return ok;
+}
+
+/* Releases every block of the file and leaves an empty root */
+bool extent_free_all(struct ipo_inode *inode) {
+    path[0].block = 0;
+    path[0].hdr = &inode->extent_root;
+    path[0].ext = inode->extents;
+    bool ok = free_node(0);
+    extent_init(inode);
+    return ok;
+}
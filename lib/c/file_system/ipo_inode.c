@@ -1,16 +1,17 @@
 #include <file_system/ipo_fs.h>
 #include <string.h>
 #include <stdio.h>
+#include <kernel/log.h>
 
 #define INODE_SIZE sizeof(struct ipo_inode)
-#define INODES_PER_BLOCK (IPO_FS_BLOCK_SIZE / INODE_SIZE)
+#define INODES_PER_BLOCK (sb.block_size / INODE_SIZE)
 
 bool read_inode(uint32_t inode_no, struct ipo_inode *out) {
     if (inode_no == 0 || inode_no > sb.inode_count) return false;
     uint32_t idx = inode_no - 1; /* inodes are numbered from 1 */
     uint32_t block = sb.inode_table_start + (idx / INODES_PER_BLOCK);
     uint32_t offset = (idx % INODES_PER_BLOCK) * INODE_SIZE;
-    uint8_t buf[IPO_FS_BLOCK_SIZE];
+    uint8_t buf[IPO_FS_MAX_BLOCK_SIZE];
     if (!block_read(block, buf)) return false;
     memcpy(out, buf + offset, sizeof(*out));
     return true;
@@ -21,7 +22,7 @@ bool write_inode(uint32_t inode_no, const struct ipo_inode *in) {
     uint32_t idx = inode_no - 1;
     uint32_t block = sb.inode_table_start + (idx / INODES_PER_BLOCK);
     uint32_t offset = (idx % INODES_PER_BLOCK) * INODE_SIZE;
-    uint8_t buf[IPO_FS_BLOCK_SIZE];
+    uint8_t buf[IPO_FS_MAX_BLOCK_SIZE];
     if (!block_read(block, buf)) return false;
     memcpy(buf + offset, in, sizeof(*in));
     return block_write(block, buf);
@@ -29,25 +30,31 @@ bool write_inode(uint32_t inode_no, const struct ipo_inode *in) {
 
 int allocate_inode(void) {
     /* Find a free bit in the inode bitmap */
-    for (uint32_t i = 0; i < sb.inode_count; i++) {
-        if (!bitmap_get(sb.inode_bitmap_start, i)) {
-            if (!bitmap_set(sb.inode_bitmap_start, i, true)) return -1;
-            /* zero the inode */
-            struct ipo_inode zero;
-            memset(&zero, 0, sizeof(zero));
-            write_inode(i + 1, &zero);
-            return i + 1;
-        }
-    }
-    return -1; /* no free inodes */
+    int i = bitmap_find_free(sb.inode_bitmap_start, sb.inode_count, 0);
+    if (i < 0) return -1; /* no free inodes */
+    if (!bitmap_set(sb.inode_bitmap_start, i, true)) return -1;
+    /* zero the inode, but keep generations unique across reuse */
+    struct ipo_inode old;
+    uint32_t generation = read_inode(i + 1, &old) ? old.generation + 1 : 0;
+    struct ipo_inode zero;
+    memset(&zero, 0, sizeof(zero));
+    zero.generation = generation;
+    write_inode(i + 1, &zero);
+    return i + 1;
 }
 
 bool free_inode(uint32_t inode_no) {
     if (inode_no == 0 || inode_no > sb.inode_count) return false;
     struct ipo_inode inode;
     if (!read_inode(inode_no, &inode)) return false;
+    if (inode.mode & IPO_INODE_FLAG_EXTENTS) {
+        extent_free_all(&inode);
+        bitmap_set(sb.inode_bitmap_start, inode_no - 1, false);
+        write_inode(inode_no, &inode);
+        return true;
+    }
     /* free all associated blocks */
-    uint32_t nblocks = (inode.size + IPO_FS_BLOCK_SIZE - 1) / IPO_FS_BLOCK_SIZE;
+    uint32_t nblocks = (inode.size + sb.block_size - 1) / sb.block_size;
     for (uint32_t i = 0; i < IPO_FS_DIRECT_BLOCKS && i < nblocks; i++) {
         if (inode.direct[i]) {
             uint32_t data_idx = inode.direct[i] - sb.data_blocks_start;
@@ -57,10 +64,10 @@ bool free_inode(uint32_t inode_no) {
     }
     /* single indirect */
     if (inode.indirect) {
-        uint8_t ibuf[IPO_FS_BLOCK_SIZE];
+        uint8_t ibuf[IPO_FS_MAX_BLOCK_SIZE];
         block_read(inode.indirect, ibuf);
         uint32_t *ptrs = (uint32_t *)ibuf;
-        for (uint32_t i = 0; i < IPO_FS_BLOCK_SIZE / 4; i++) {
+        for (uint32_t i = 0; i < sb.block_size / 4; i++) {
             if (ptrs[i]) {
                 uint32_t data_idx = ptrs[i] - sb.data_blocks_start;
                 bitmap_set(sb.block_bitmap_start, data_idx, false);
@@ -70,26 +77,71 @@ bool free_inode(uint32_t inode_no) {
         bitmap_set(sb.block_bitmap_start, inode.indirect - sb.data_blocks_start, false);
         inode.indirect = 0;
     }
+    if (inode.index_blocks) dir_index_free(&inode);
     /* clear inode bitmap */
     bitmap_set(sb.inode_bitmap_start, inode_no - 1, false);
     write_inode(inode_no, &inode);
     return true;
 }
 
+/* Data block index to search from next, so files are laid out one after another */
+static uint32_t block_alloc_hint = 0;
+
+/* Marks data block i used and, if asked, zeroes it; returns its physical index */
+static int claim_block(uint32_t i, bool zero) {
+    if (!bitmap_set(sb.block_bitmap_start, i, true)) { LOG_ERR(LOG_FS, "allocate_block: bitmap_set failed at %u\n", i); return -1; }
+    /* clear block */
+    if (zero) {
+        uint8_t buf[IPO_FS_MAX_BLOCK_SIZE];
+        memset(buf, 0, sizeof(buf));
+        if (!block_write(sb.data_blocks_start + i, buf)) { LOG_ERR(LOG_FS, "allocate_block: block_write clear failed at %u\n", sb.data_blocks_start + i); return -1; }
+    }
+    block_alloc_hint = i + 1;
+    return sb.data_blocks_start + i; /* physical block index */
+}
+
+static int claim_free_block(bool zero) {
+    uint32_t data_blocks_total = sb.fs_size_blocks - sb.data_blocks_start;
+    int i = bitmap_find_free(sb.block_bitmap_start, data_blocks_total, block_alloc_hint);
+    if (i < 0) {
+        LOG_ERR(LOG_FS, "allocate_block: no free blocks\n");
+        return -1; /* no space */
+    }
+    return claim_block(i, zero);
+}
+
 int allocate_block(void) {
+    return claim_free_block(true);
+}
+
+/*
+ * Allocates goal itself if it is a free data block, else any block.
+ * Without zero the block keeps whatever it held: only for callers that
+ * overwrite all of it before anything reads it.
+ */
+int allocate_block_near(uint32_t goal, bool zero) {
+    if (goal >= sb.data_blocks_start && goal < sb.fs_size_blocks) {
+        uint32_t i = goal - sb.data_blocks_start;
+        if (!bitmap_get(sb.block_bitmap_start, i)) return claim_block(i, zero);
+    }
+    return claim_free_block(zero);
+}
+
+/* Allocates count contiguous zeroed data blocks; returns the first one */
+int allocate_blocks(uint32_t count) {
     uint32_t data_blocks_total = sb.fs_size_blocks - sb.data_blocks_start;
-    for (uint32_t i = 0; i < data_blocks_total; i++) {
-        if (!bitmap_get(sb.block_bitmap_start, i)) {
-            if (!bitmap_set(sb.block_bitmap_start, i, true)) { printf("allocate_block: bitmap_set failed at %u\n", i); return -1; }
-            /* clear block */
-            uint8_t zero[IPO_FS_BLOCK_SIZE];
-            memset(zero, 0, sizeof(zero));
-            if (!block_write(sb.data_blocks_start + i, zero)) { printf("allocate_block: block_write clear failed at %u\n", sb.data_blocks_start + i); return -1; }
-            return sb.data_blocks_start + i; /* physical block index */
+    int i = bitmap_find_free_run(sb.block_bitmap_start, data_blocks_total, count, block_alloc_hint);
+    if (i < 0) {
+        LOG_ERR(LOG_FS, "allocate_blocks: no run of %u free blocks\n", count);
+        return -1;
+    }
+    for (uint32_t k = 0; k < count; k++) {
+        if (claim_block((uint32_t)i + k, true) < 0) {
+            while (k--) free_block(sb.data_blocks_start + (uint32_t)i + k);
+            return -1;
         }
     }
-    printf("allocate_block: no free blocks\n");
-    return -1; /* no space */
+    return sb.data_blocks_start + i;
 }
 
 bool free_block(uint32_t phys_block) {
@@ -99,6 +151,11 @@ bool free_block(uint32_t phys_block) {
 }
 
 int get_data_block_for_inode(struct ipo_inode *inode, uint32_t logical_index, bool alloc) {
+    if (inode->mode & IPO_INODE_FLAG_EXTENTS) {
+        if (alloc) return extent_map_alloc(inode, logical_index, true);
+        return extent_map(inode, logical_index, NULL);
+    }
+
     if (logical_index < IPO_FS_DIRECT_BLOCKS) {
         if (!inode->direct[logical_index]) {
             if (!alloc) return -1;
@@ -109,18 +166,18 @@ int get_data_block_for_inode(struct ipo_inode *inode, uint32_t logical_index, bo
         return inode->direct[logical_index];
     }
     
-    uint32_t per_block = IPO_FS_BLOCK_SIZE / 4;
+    uint32_t per_block = sb.block_size / 4;
     uint32_t idx = logical_index - IPO_FS_DIRECT_BLOCKS;
     
     /* single indirect */
     if (idx < per_block) {
-        uint8_t ibuf[IPO_FS_BLOCK_SIZE];
+        uint8_t ibuf[IPO_FS_MAX_BLOCK_SIZE];
         if (!inode->indirect) {
             if (!alloc) return -1;
             int indirect_block = allocate_block();
             if (indirect_block < 0) return -1;
             inode->indirect = indirect_block;
-            uint8_t zero[IPO_FS_BLOCK_SIZE]; memset(zero,0,sizeof(zero));
+            uint8_t zero[IPO_FS_MAX_BLOCK_SIZE]; memset(zero,0,sizeof(zero));
             block_write(indirect_block, zero);
         }
         if (!block_read(inode->indirect, ibuf)) return -1;
@@ -139,15 +196,15 @@ int get_data_block_for_inode(struct ipo_inode *inode, uint32_t logical_index, bo
     idx -= per_block;
     if (idx >= per_block * per_block) return -1;
     
-    uint8_t dibuf[IPO_FS_BLOCK_SIZE];  // double indirect block
-    uint8_t ibuf[IPO_FS_BLOCK_SIZE];   // single indirect block
+    uint8_t dibuf[IPO_FS_MAX_BLOCK_SIZE];  // double indirect block
+    uint8_t ibuf[IPO_FS_MAX_BLOCK_SIZE];   // single indirect block
     
     if (!inode->double_indirect) {
         if (!alloc) return -1;
         int di_block = allocate_block();
         if (di_block < 0) return -1;
         inode->double_indirect = di_block;
-        uint8_t zero[IPO_FS_BLOCK_SIZE]; memset(zero,0,sizeof(zero));
+        uint8_t zero[IPO_FS_MAX_BLOCK_SIZE]; memset(zero,0,sizeof(zero));
         block_write(di_block, zero);
     }
     
@@ -163,7 +220,7 @@ int get_data_block_for_inode(struct ipo_inode *inode, uint32_t logical_index, bo
         if (si_block < 0) return -1;
         di_ptrs[di_idx] = si_block;
         block_write(inode->double_indirect, dibuf);
-        uint8_t zero[IPO_FS_BLOCK_SIZE]; memset(zero,0,sizeof(zero));
+        uint8_t zero[IPO_FS_MAX_BLOCK_SIZE]; memset(zero,0,sizeof(zero));
         block_write(si_block, zero);
     }
     
@@ -180,3 +237,39 @@ int get_data_block_for_inode(struct ipo_inode *inode, uint32_t logical_index, bo
     
     return si_ptrs[si_idx];
 }
+
+/* get_data_block_for_inode, leaving new extent blocks unzeroed for IPO_MAP_OVERWRITE */
+static int map_block(struct ipo_inode *inode, uint32_t logical_index, ipo_map_mode_t mode) {
+    if (mode == IPO_MAP_OVERWRITE && (inode->mode & IPO_INODE_FLAG_EXTENTS)) {
+        return extent_map_alloc(inode, logical_index, false);
+    }
+    return get_data_block_for_inode(inode, logical_index, mode != IPO_MAP_LOOKUP);
+}
+
+/*
+ * Maps logical_index and counts how many following blocks, up to
+ * max_blocks, are physically contiguous with it, so callers can move
+ * the whole run in one transfer. An extent lookup gives the run from
+ * its extent alone; block-mapped inodes and allocations are probed
+ * block by block.
+ */
+int get_data_run_for_inode(struct ipo_inode *inode, uint32_t logical_index, uint32_t max_blocks, ipo_map_mode_t mode, uint32_t *out_run) {
+    uint32_t run = 1;
+    int phys;
+    if ((inode->mode & IPO_INODE_FLAG_EXTENTS) && mode == IPO_MAP_LOOKUP) {
+        phys = extent_map(inode, logical_index, &run);
+        if (phys < 0) return -1;
+        *out_run = run < max_blocks ? run : max_blocks;
+        return phys;
+    }
+
+    phys = map_block(inode, logical_index, mode);
+    if (phys < 0) return -1;
+    while (run < max_blocks) {
+        int next = map_block(inode, logical_index + run, mode);
+        if (next != phys + (int)run) break;
+        run++;
+    }
+    *out_run = run;
+    return phys;
+}
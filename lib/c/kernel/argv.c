@@ -0,0 +1,100 @@
+#include <kernel/argv.h>
+#include <kernel/process.h>
+#include <memory/kmalloc.h>
+#include <string.h>
+
+static inline int is_separator(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+/**
+ * next_token - Finds the next token at or after p
+ * Returns the position after the token, or NULL when there are no more.
+ */
+static const char *next_token(const char *p, const char **start, size_t *len) {
+    while (*p && is_separator(*p)) p++;
+    if (*p == '\0') return NULL;
+    
+    *start = p;
+    while (*p && !is_separator(*p)) p++;
+    *len = (size_t)(p - *start);
+    if (*len > MAX_ARG_LENGTH - 1) {
+        *len = MAX_ARG_LENGTH - 1;
+    }
+    return p;
+}
+
+/**
+ * argv_block_alloc - Allocates the pointer array plus string space
+ */
+static char **argv_block_alloc(int argc, size_t string_bytes, char **strings_out) {
+    size_t array_size = (size_t)(argc + 1) * sizeof(char *);
+    char **block = kmalloc(array_size + string_bytes);
+    if (!block) return NULL;
+    
+    *strings_out = (char *)block + array_size;
+    return block;
+}
+
+char **argv_block_from_cmdline(const char *cmdline, int *argc_out) {
+    *argc_out = 0;
+    if (!cmdline) return NULL;
+    
+    // First pass: count tokens and the bytes they need
+    int argc = 0;
+    size_t string_bytes = 0;
+    const char *p = cmdline;
+    const char *start;
+    size_t len;
+    while (argc < MAX_ARGV_COUNT && (p = next_token(p, &start, &len)) != NULL) {
+        string_bytes += len + 1;
+        argc++;
+    }
+    if (argc == 0) return NULL;
+    
+    char *strings;
+    char **argv = argv_block_alloc(argc, string_bytes, &strings);
+    if (!argv) return NULL;
+    
+    // Second pass: copy the tokens into the block
+    p = cmdline;
+    for (int i = 0; i < argc; i++) {
+        p = next_token(p, &start, &len);
+        memcpy(strings, start, len);
+        strings[len] = '\0';
+        argv[i] = strings;
+        strings += len + 1;
+    }
+    argv[argc] = NULL;
+    
+    *argc_out = argc;
+    return argv;
+}
+
+char **argv_block_pack(int argc, char **argv, int *argc_out) {
+    *argc_out = 0;
+    if (argc <= 0 || !argv) return NULL;
+    if (argc > MAX_ARGV_COUNT) argc = MAX_ARGV_COUNT;
+    
+    size_t string_bytes = 0;
+    int count = 0;
+    while (count < argc && argv[count]) {
+        string_bytes += strlen(argv[count]) + 1;
+        count++;
+    }
+    
+    char *strings;
+    char **block = argv_block_alloc(count, string_bytes, &strings);
+    if (!block) return NULL;
+    
+    for (int i = 0; i < count; i++) {
+        size_t len = strlen(argv[i]) + 1;
+        memcpy(strings, argv[i], len);
+        block[i] = strings;
+        strings += len;
+    }
+    block[count] = NULL;
+    
+    *argc_out = count;
+    return block;
+}
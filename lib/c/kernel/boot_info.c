@@ -0,0 +1,92 @@
+#include <kernel/boot_info.h>
+#include <string.h>
+#include <stdio.h>
+
+static boot_info_t info;
+
+static void copy_string(char *dst, uint32_t src_addr, size_t size) {
+    const char *src = (const char *)src_addr;
+    size_t i = 0;
+    while (i + 1 < size && src[i]) {
+        dst[i] = src[i];
+        i++;
+    }
+    dst[i] = '\0';
+}
+
+void boot_info_init(uint32_t magic, uint32_t info_addr) {
+    if (magic != MULTIBOOT_BOOTLOADER_MAGIC || info_addr == 0) {
+        strcpy(info.loader, "IPO_OS stage2");
+        return;
+    }
+
+    const multiboot_info_t *mb = (const multiboot_info_t *)info_addr;
+    info.multiboot = 1;
+
+    if (mb->flags & MULTIBOOT_INFO_LOADER) {
+        copy_string(info.loader, mb->boot_loader_name, sizeof(info.loader));
+    } else {
+        strcpy(info.loader, "Multiboot");
+    }
+
+    if (mb->flags & MULTIBOOT_INFO_CMDLINE) {
+        copy_string(info.cmdline, mb->cmdline, sizeof(info.cmdline));
+    }
+
+    if (mb->flags & MULTIBOOT_INFO_MEMORY) {
+        info.mem_lower_kb = mb->mem_lower;
+        info.mem_upper_kb = mb->mem_upper;
+    }
+
+    if (mb->flags & MULTIBOOT_INFO_MMAP) {
+        uint32_t addr = mb->mmap_addr;
+        uint32_t end = mb->mmap_addr + mb->mmap_length;
+        while (addr < end && info.mmap_count < BOOT_MMAP_MAX) {
+            const multiboot_mmap_entry_t *e = (const multiboot_mmap_entry_t *)addr;
+            boot_mmap_entry_t *out = &info.mmap[info.mmap_count++];
+            out->addr = e->addr;
+            out->len = e->len;
+            out->type = e->type;
+            addr += e->size + sizeof(e->size);
+        }
+    }
+}
+
+const boot_info_t *boot_info_get(void) {
+    return &info;
+}
+
+int boot_cmdline_value(const char *key, char *out, size_t size) {
+    size_t key_len = strlen(key);
+    const char *p = info.cmdline;
+
+    while (*p) {
+        while (*p == ' ') p++;
+        const char *word = p;
+        while (*p && *p != ' ') p++;
+
+        if ((size_t)(p - word) > key_len && word[key_len] == '=' &&
+            memcmp(word, key, key_len) == 0) {
+            const char *value = word + key_len + 1;
+            size_t len = (size_t)(p - value);
+            if (len >= size) len = size - 1;
+            memcpy(out, value, len);
+            out[len] = '\0';
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void boot_info_print(sink_t *out) {
+    sink_printf(out, "Loader: %s\n", info.loader);
+    if (!info.multiboot) return;
+
+    sink_printf(out, "Command line: %s\n", info.cmdline[0] ? info.cmdline : "(none)");
+    sink_printf(out, "Memory: %u KB low, %u KB high\n", info.mem_lower_kb, info.mem_upper_kb);
+    for (uint32_t i = 0; i < info.mmap_count; i++) {
+        const boot_mmap_entry_t *e = &info.mmap[i];
+        sink_printf(out, "  %08llx-%08llx %s\n", e->addr, e->addr + e->len - 1,
+                    e->type == MULTIBOOT_MEMORY_AVAILABLE ? "available" : "reserved");
+    }
+}
@@ -0,0 +1,83 @@
+#include <kernel/boot_timeline.h>
+#include <kernel/log.h>
+#include <system/cpu.h>
+#include <system/tsc.h>
+#include <string.h>
+#include <stdio.h>
+
+static boot_stage_t stages[BOOT_STAGE_MAX];
+static uint32_t stage_count = 0;
+static uint64_t last_mark = 0;
+static int have_tsc = 0;
+
+static uint64_t now(void) {
+    return have_tsc ? cpu_rdtsc() : 0;
+}
+
+static void record(const char *name, uint64_t start, uint64_t end) {
+    if (stage_count >= BOOT_STAGE_MAX) return;
+
+    boot_stage_t *stage = &stages[stage_count++];
+    stage->name = name;
+    stage->start = start;
+    stage->end = end;
+    stage->repeated = 0;
+
+    for (uint32_t i = 0; i + 1 < stage_count; i++) {
+        if (strcmp(stages[i].name, name) == 0) {
+            stage->repeated = 1;
+            LOG_WARN(LOG_KERNEL, "boot stage %s ran again\n", name);
+            break;
+        }
+    }
+}
+
+void boot_timeline_start(void) {
+    have_tsc = cpu_has_feature_edx(CPUID_EDX_TSC);
+    stage_count = 0;
+    last_mark = now();
+
+    // The TSC starts at reset, so everything before kernel entry is one stage
+    record("firmware+loader", 0, last_mark);
+}
+
+void boot_timeline_mark(const char *name) {
+    uint64_t t = now();
+    record(name, last_mark, t);
+    last_mark = t;
+}
+
+static uint64_t total_cycles(void) {
+    return stage_count ? stages[stage_count - 1].end : 0;
+}
+
+void boot_timeline_print(sink_t *out) {
+    if (!have_tsc || tsc_get_khz() == 0) {
+        sink_printf(out, "boottime: no calibrated TSC\n");
+        return;
+    }
+
+    uint64_t total = total_cycles();
+    sink_printf(out, "%-18s %12s %6s\n", "stage", "ms", "%");
+    for (uint32_t i = 0; i < stage_count; i++) {
+        const boot_stage_t *s = &stages[i];
+        uint64_t cycles = s->end - s->start;
+        uint32_t us = (uint32_t)tsc_cycles_to_us(cycles);
+        uint32_t permille = total ? (uint32_t)(cycles * 1000 / total) : 0;
+        sink_printf(out, "%-18s %8u.%03u %4u.%u%s\n", s->name, us / 1000, us % 1000,
+                    permille / 10, permille % 10, s->repeated ? "  (repeated)" : "");
+    }
+    uint32_t total_us = (uint32_t)tsc_cycles_to_us(total);
+    sink_printf(out, "%-18s %8u.%03u\n", "total", total_us / 1000, total_us % 1000);
+}
+
+void boot_timeline_dump_serial(void) {
+    for (uint32_t i = 0; i < stage_count; i++) {
+        const boot_stage_t *s = &stages[i];
+        serial_printf("boottime %u %s %u %u%s\n", i, s->name,
+                      (uint32_t)tsc_cycles_to_us(s->start),
+                      (uint32_t)tsc_cycles_to_us(s->end - s->start),
+                      s->repeated ? " repeated" : "");
+    }
+    serial_printf("boottime total %u\n", (uint32_t)tsc_cycles_to_us(total_cycles()));
+}
@@ -0,0 +1,127 @@
+#include <kernel/image_cache.h>
+#include <memory/kmalloc.h>
+#include <string.h>
+#include <stdio.h>
+#include <kernel/log.h>
+
+typedef struct {
+    uint8_t used;
+    uint32_t inode;
+    uint32_t size;
+    uint32_t generation;
+    void *image;
+    uint32_t last_used;     // LRU stamp, larger is more recent
+} image_cache_entry_t;
+
+static image_cache_entry_t entries[IMAGE_CACHE_MAX_ENTRIES];
+static uint32_t cache_bytes = 0;
+static uint32_t cache_tick = 0;
+static uint32_t cache_hits = 0;
+static uint32_t cache_misses = 0;
+
+static void release_entry(image_cache_entry_t *e) {
+    if (!e->used) return;
+    kfree(e->image);
+    cache_bytes -= e->size;
+    memset(e, 0, sizeof(*e));
+}
+
+/**
+ * evict_lru - Releases the least recently used entry
+ * Returns 0 if the cache is already empty.
+ */
+static int evict_lru(void) {
+    image_cache_entry_t *victim = NULL;
+    for (int i = 0; i < IMAGE_CACHE_MAX_ENTRIES; i++) {
+        if (entries[i].used && (!victim || entries[i].last_used < victim->last_used)) {
+            victim = &entries[i];
+        }
+    }
+    if (!victim) return 0;
+    
+    LOG_DEBUG(LOG_PROC, "image_cache: evicting inode %u (%u bytes)\n", victim->inode, victim->size);
+    release_entry(victim);
+    return 1;
+}
+
+void image_cache_init(void) {
+    // The heap may have been reset under us, so never kfree() here
+    memset(entries, 0, sizeof(entries));
+    cache_bytes = 0;
+    cache_tick = 0;
+    cache_hits = 0;
+    cache_misses = 0;
+}
+
+const void *image_cache_lookup(uint32_t inode, uint32_t size, uint32_t generation) {
+    for (int i = 0; i < IMAGE_CACHE_MAX_ENTRIES; i++) {
+        image_cache_entry_t *e = &entries[i];
+        if (!e->used || e->inode != inode) continue;
+        
+        if (e->size != size || e->generation != generation) {
+            // File changed since it was cached
+            release_entry(e);
+            break;
+        }
+        
+        e->last_used = ++cache_tick;
+        cache_hits++;
+        return e->image;
+    }
+    
+    cache_misses++;
+    return NULL;
+}
+
+int image_cache_insert(uint32_t inode, uint32_t size, uint32_t generation, void *image) {
+    if (!image || size == 0 || size > IMAGE_CACHE_BUDGET) {
+        return 0;
+    }
+    
+    image_cache_invalidate(inode);
+    
+    while (cache_bytes + size > IMAGE_CACHE_BUDGET) {
+        if (!evict_lru()) return 0;
+    }
+    
+    image_cache_entry_t *slot = NULL;
+    for (int i = 0; i < IMAGE_CACHE_MAX_ENTRIES; i++) {
+        if (!entries[i].used) {
+            slot = &entries[i];
+            break;
+        }
+    }
+    if (!slot) {
+        evict_lru();
+        for (int i = 0; i < IMAGE_CACHE_MAX_ENTRIES; i++) {
+            if (!entries[i].used) {
+                slot = &entries[i];
+                break;
+            }
+        }
+        if (!slot) return 0;
+    }
+    
+    slot->used = 1;
+    slot->inode = inode;
+    slot->size = size;
+    slot->generation = generation;
+    slot->image = image;
+    slot->last_used = ++cache_tick;
+    cache_bytes += size;
+    return 1;
+}
+
+void image_cache_invalidate(uint32_t inode) {
+    for (int i = 0; i < IMAGE_CACHE_MAX_ENTRIES; i++) {
+        if (entries[i].used && entries[i].inode == inode) {
+            release_entry(&entries[i]);
+        }
+    }
+}
+
+void image_cache_get_stats(uint32_t *hits, uint32_t *misses, uint32_t *bytes) {
+    if (hits) *hits = cache_hits;
+    if (misses) *misses = cache_misses;
+    if (bytes) *bytes = cache_bytes;
+}
@@ -0,0 +1,80 @@
+#include <kernel/log.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+
+#define LOG_LINE_MAX 256
+
+uint8_t log_levels[LOG_SUBSYSTEM_COUNT] = {
+    [LOG_KERNEL] = LOG_DEFAULT_LEVEL,
+    [LOG_PROC]   = LOG_DEFAULT_LEVEL,
+    [LOG_FS]     = LOG_DEFAULT_LEVEL,
+    [LOG_ATA]    = LOG_DEFAULT_LEVEL,
+};
+
+static const char *subsystem_names[LOG_SUBSYSTEM_COUNT] = {
+    [LOG_KERNEL] = "kernel",
+    [LOG_PROC]   = "proc",
+    [LOG_FS]     = "fs",
+    [LOG_ATA]    = "ata",
+};
+
+static const char *level_names[] = {
+    "none", "error", "warn", "info", "debug", "trace"
+};
+
+#define LEVEL_COUNT (int)(sizeof(level_names) / sizeof(level_names[0]))
+
+void log_write(log_subsystem_t sub, int level, const char *format, ...) {
+    char line[LOG_LINE_MAX];
+    int prefix = snprintf(line, sizeof(line), "[%s] ", subsystem_names[sub]);
+    
+    // Format once, then hand the same bytes to every output
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(line + prefix, sizeof(line) - prefix, format, args);
+    va_end(args);
+    
+    if (len < 0) return;
+    if ((size_t)(prefix + len) >= sizeof(line)) len = sizeof(line) - 1 - prefix;
+    
+    serial_write(line, prefix + len);
+    if (level <= LOG_LEVEL_WARN) {
+        console_write(line + prefix, len);
+    }
+}
+
+void log_set_level(log_subsystem_t sub, int level) {
+    if ((int)sub < 0 || sub >= LOG_SUBSYSTEM_COUNT) return;
+    if (level < LOG_LEVEL_NONE) level = LOG_LEVEL_NONE;
+    if (level > LOG_LEVEL_TRACE) level = LOG_LEVEL_TRACE;
+    log_levels[sub] = (uint8_t)level;
+}
+
+const char *log_subsystem_name(log_subsystem_t sub) {
+    if ((int)sub < 0 || sub >= LOG_SUBSYSTEM_COUNT) return "?";
+    return subsystem_names[sub];
+}
+
+const char *log_level_name(int level) {
+    if (level < 0 || level >= LEVEL_COUNT) return "?";
+    return level_names[level];
+}
+
+int log_find_subsystem(const char *name) {
+    for (int i = 0; i < LOG_SUBSYSTEM_COUNT; i++) {
+        if (strcmp(subsystem_names[i], name) == 0) return i;
+    }
+    return -1;
+}
+
+int log_parse_level(const char *name) {
+    if (name[0] >= '0' && name[0] <= '9' && name[1] == '\0') {
+        int level = name[0] - '0';
+        return level < LEVEL_COUNT ? level : -1;
+    }
+    for (int i = 0; i < LEVEL_COUNT; i++) {
+        if (strcmp(level_names[i], name) == 0) return i;
+    }
+    return -1;
+}
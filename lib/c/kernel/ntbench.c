@@ -0,0 +1,71 @@
+#include <kernel/ntbench.h>
+#include <memory/kmalloc.h>
+#include <system/sse.h>
+#include <system/tsc.h>
+#include <string.h>
+
+#define NTBENCH_MAX_SIZE (4 * 1024 * 1024)
+
+/* All of them reach the streaming path (STRING_NT_MIN in string.c) */
+static const uint32_t sizes[] = { 64 * 1024, 256 * 1024, 1024 * 1024, NTBENCH_MAX_SIZE };
+#define SIZE_COUNT (sizeof(sizes) / sizeof(sizes[0]))
+
+/* Bytes over cycles at khz kHz, in MB/s */
+static uint32_t mb_per_s(uint64_t bytes, uint64_t cycles, uint32_t khz) {
+    if (cycles == 0) return 0;
+    return (uint32_t)(bytes * khz / cycles / 1000);
+}
+
+static uint64_t time_memcpy(uint8_t *dst, const uint8_t *src, uint32_t size, uint32_t iterations) {
+    uint64_t start = tsc_read();
+    for (uint32_t i = 0; i < iterations; i++) memcpy(dst, src, size);
+    return tsc_read() - start;
+}
+
+static uint64_t time_memset(uint8_t *dst, uint32_t size, uint32_t iterations) {
+    uint64_t start = tsc_read();
+    for (uint32_t i = 0; i < iterations; i++) memset(dst, (int)i, size);
+    return tsc_read() - start;
+}
+
+bool ntbench_run(sink_t *out, uint32_t mb) {
+    uint32_t khz = tsc_get_khz();
+    if (khz == 0) {
+        sink_printf(out, "ntbench: TSC not calibrated\n");
+        return false;
+    }
+
+    uint8_t *src = kmalloc(NTBENCH_MAX_SIZE);
+    uint8_t *dst = kmalloc(NTBENCH_MAX_SIZE);
+    if (!src || !dst) {
+        sink_printf(out, "ntbench: out of memory\n");
+        kfree(src);
+        kfree(dst);
+        return false;
+    }
+
+    bool nt = sse_enabled();
+    if (!nt) sink_printf(out, "ntbench: SSE2 not enabled, nt is the rep path\n");
+
+    for (uint32_t s = 0; s < SIZE_COUNT; s++) {
+        uint32_t size = sizes[s];
+        uint32_t iterations = mb * 1024 / (size / 1024);
+        if (iterations == 0) iterations = 1;
+        uint64_t bytes = (uint64_t)size * iterations;
+
+        // The rep path is what memcpy/memset run with streaming switched off
+        string_use_sse(false);
+        uint32_t copy_rep = mb_per_s(bytes, time_memcpy(dst, src, size, iterations), khz);
+        uint32_t set_rep = mb_per_s(bytes, time_memset(dst, size, iterations), khz);
+        string_use_sse(nt);
+        uint32_t copy_nt = mb_per_s(bytes, time_memcpy(dst, src, size, iterations), khz);
+        uint32_t set_nt = mb_per_s(bytes, time_memset(dst, size, iterations), khz);
+
+        sink_printf(out, "ntbench memcpy %4u KB rep %6u nt %6u MB/s\n", size / 1024, copy_rep, copy_nt);
+        sink_printf(out, "ntbench memset %4u KB rep %6u nt %6u MB/s\n", size / 1024, set_rep, set_nt);
+    }
+
+    kfree(src);
+    kfree(dst);
+    return true;
+}
@@ -0,0 +1,63 @@
+#include <kernel/pipe.h>
+#include <memory/kmalloc.h>
+#include <string.h>
+
+pipe_t *pipe_create(uint32_t capacity) {
+    if (capacity == 0) return NULL;
+    
+    pipe_t *pipe = kmalloc(sizeof(pipe_t));
+    if (!pipe) return NULL;
+    
+    pipe->data = kmalloc(capacity);
+    if (!pipe->data) {
+        kfree(pipe);
+        return NULL;
+    }
+    pipe->capacity = capacity;
+    return pipe;
+}
+
+void pipe_destroy(pipe_t *pipe) {
+    if (!pipe) return;
+    kfree(pipe->data);
+    kfree(pipe);
+}
+
+int pipe_write(pipe_t *pipe, const void *buf, uint32_t len) {
+    if (!pipe || !buf || pipe->write_closed) return -1;
+    
+    uint32_t space = pipe->capacity - pipe->count;
+    if (len > space) {
+        pipe->dropped += len - space;
+        len = space;
+    }
+    
+    // At most two copies: up to the end of the ring, then from its start
+    uint32_t tail = (pipe->head + pipe->count) % pipe->capacity;
+    uint32_t first = pipe->capacity - tail;
+    if (first > len) first = len;
+    memcpy(pipe->data + tail, buf, first);
+    memcpy(pipe->data, (const uint8_t *)buf + first, len - first);
+    
+    pipe->count += len;
+    return (int)len;
+}
+
+int pipe_read(pipe_t *pipe, void *buf, uint32_t len) {
+    if (!pipe || !buf) return -1;
+    
+    if (len > pipe->count) len = pipe->count;
+    
+    uint32_t first = pipe->capacity - pipe->head;
+    if (first > len) first = len;
+    memcpy(buf, pipe->data + pipe->head, first);
+    memcpy((uint8_t *)buf + first, pipe->data, len - first);
+    
+    pipe->head = (pipe->head + len) % pipe->capacity;
+    pipe->count -= len;
+    return (int)len;
+}
+
+void pipe_close_write(pipe_t *pipe) {
+    if (pipe) pipe->write_closed = 1;
+}
@@ -1,9 +1,14 @@
 #include <kernel/process.h>
+#include <kernel/syscall.h>
+#include <kernel/argv.h>
+#include <kernel/image_cache.h>
 #include <file_system/ipo_fs.h>
 #include <memory/kmalloc.h>
+#include <system/tsc.h>
 #include <vga.h>
 #include <string.h>
 #include <stdio.h>
+#include <kernel/log.h>
 #include <stdarg.h>
 
 /**
@@ -13,16 +18,20 @@ typedef struct {
     uint8_t magic[8];
     uint32_t entry_offset;
     uint32_t total_size;
-    uint32_t reserved;
+    uint32_t flags;
 } ipob_header_t;
 
 #define IPOB_HEADER_SIZE 20
 
+/* ipob_header_t.flags */
+#define IPOB_FLAG_USER 0x1  // Run in ring 3, talk to the kernel through syscalls only
+
 // Global variables
 static int last_exit_code = 0;
 static process_t *current_process = NULL;
 static process_t *process_list = NULL;
 static uint32_t next_pid = 1;
+static process_stats_t last_stats;
 
 /**
  * process_init - Initialize process manager
@@ -31,6 +40,9 @@ void process_init(void) {
     // Initialize memory allocator
     kmalloc_init();
     
+    // Cached images lived in the old heap
+    image_cache_init();
+    
     printf("Process manager initialized\n");
 }
 
@@ -72,52 +84,55 @@ static uint32_t copy_string_to_process(process_t *proc, const char *str) {
 }
 
 /**
- * setup_arguments - Sets the command line arguments and returns the address of argv
+ * setup_arguments - Attaches an argument block to the process
+ *
+ * The block (see kernel/argv.h) becomes owned by the process and is
+ * released by process_cleanup() with a single kfree().
  */
-static int setup_arguments(process_t *proc, int argc, char **argv, uint32_t *argv_addr_out) {
-    if (argc == 0 || argv == NULL) {
-        proc->argc = 0;
-        *argv_addr_out = 0;
-        return 0;
-    }
-    
-    // Limiting the number of arguments
-    if (argc > MAX_ARGV_COUNT) {
-        argc = MAX_ARGV_COUNT;
-    }
-    
-    // Allocate memory in the kernel for the argv pointer array
-    uint32_t argv_array_size = (argc + 1) * sizeof(uint32_t);
-    char **argv_array = kmalloc((argc + 1) * sizeof(char *));
-    if (!argv_array) {
-        return -1;
+static void setup_arguments(process_t *proc, int argc, char **argv_block) {
+    proc->argc = argv_block ? argc : 0;
+    proc->argv_kernel = argv_block;
+    proc->argv_addr = (uint32_t)argv_block;
+    
+    // The strings follow the array in order, so the last one ends the block
+    proc->argv_size = 0;
+    if (proc->argc > 0) {
+        const char *last = argv_block[proc->argc - 1];
+        proc->argv_size = (uint32_t)(last + strlen(last) + 1 - (const char *)argv_block);
     }
-    
-    // Copy the arguments and save their addresses
-    for (int i = 0; i < argc; i++) {
-        if (argv[i] == NULL) {
-            argc = i;
-            break;
-        }
-        // Allocate memory for the argument string
-        size_t arg_len = strlen(argv[i]) + 1;
-        char *arg_copy = kmalloc(arg_len);
-        if (!arg_copy) {
-            return -1;
-        }
-        strcpy(arg_copy, argv[i]);
-        argv_array[i] = arg_copy;
-    }
-    argv_array[argc] = 0;
-    
-    // Saving information
-    proc->argc = argc;
-    *argv_addr_out = (uint32_t)argv_array;  // The address of the argv array in kernel memory
-    
-    // We save a copy in the process for cleaning
-    proc->argv_kernel = argv_array;
-    
-    return 0;
+}
+
+/**
+ * accounting_begin - Snapshots the counters a process is measured against
+ */
+static void accounting_begin(process_t *proc) {
+    kmalloc_stats_t heap;
+    kmalloc_get_stats(&heap);
+    proc->heap_base = heap.bytes_in_use;
+    proc->saved_peak = kmalloc_reset_peak();
+    ata_get_io_stats(&proc->io_base);
+    proc->stats.start_cycles = tsc_read();
+}
+
+/**
+ * accounting_end - Fills proc->stats and keeps them as the last process stats
+ */
+static void accounting_end(process_t *proc) {
+    proc->stats.end_cycles = tsc_read();
+    
+    ata_io_stats_t io;
+    ata_get_io_stats(&io);
+    proc->stats.sectors_read = io.sectors_read - proc->io_base.sectors_read;
+    proc->stats.sectors_written = io.sectors_written - proc->io_base.sectors_written;
+    proc->stats.read_commands = io.read_commands - proc->io_base.read_commands;
+    proc->stats.write_commands = io.write_commands - proc->io_base.write_commands;
+    
+    kmalloc_stats_t heap;
+    kmalloc_get_stats(&heap);
+    proc->stats.peak_heap = heap.peak_bytes - proc->heap_base;
+    kmalloc_merge_peak(proc->saved_peak);
+    
+    last_stats = proc->stats;
 }
 
 /**
@@ -133,51 +148,48 @@ static uint32_t setup_stack(process_t *proc) {
 
 /**
  * load_ipob_file - Downloads IPOB file with large file support
+ * @ino: Inode the path resolved to
+ * @inode: Inode contents, read once by the caller
  */
-static int load_ipob_file(const char *path, ipob_header_t *header_out, void **data_out) {
-    if (data_out == NULL) {
+static int load_ipob_file(const char *path, uint32_t ino, const struct ipo_inode *inode,
+                          ipob_header_t *header_out, void **data_out) {
+    if (data_out == NULL || inode == NULL) {
         return -1;
     }
     
     *data_out = NULL;
-    
-    // Checking the existence of a file
-    struct ipo_inode stat;
-    if (!ipo_fs_stat(path, &stat)) {
-        printf("File not found: %s\n", path);
-        return -1;  // File not found
-    }
+    struct ipo_inode stat = *inode;
     
     if ((stat.mode & IPO_INODE_TYPE_DIR) != 0) {
-        printf("Path is a directory: %s\n", path);
+        LOG_ERR(LOG_PROC, "Path is a directory: %s\n", path);
         return -1;  // Path is a directory
     }
     
     if (stat.size < IPOB_HEADER_SIZE) {
-        printf("File too small: %s (%d bytes)\n", path, stat.size);
+        LOG_ERR(LOG_PROC, "File too small: %s (%d bytes)\n", path, stat.size);
         return -1;  // File too small for header
     }
     
     if (stat.size > MAX_PROCESS_SIZE) {
-        printf("File too large: %s (%d bytes, max %d)\n", 
+        LOG_ERR(LOG_PROC, "File too large: %s (%d bytes, max %d)\n", 
                path, stat.size, MAX_PROCESS_SIZE);
         return -1;  // File too large
     }
     
-    serial_printf("Loading file: %s, size: %d bytes\n", path, stat.size);
+    LOG_DEBUG(LOG_PROC, "Loading file: %s, size: %d bytes\n", path, stat.size);
     
     // For large files, we use step-by-step loading.
     void *binary_image = kmalloc(stat.size);
     if (binary_image == NULL) {
-        printf("Memory allocation failed for size: %d\n", stat.size);
+        LOG_ERR(LOG_PROC, "Memory allocation failed for size: %d\n", stat.size);
         return -3;  // Memory allocation failed
     }
     
     // Open the file
-    int fd = ipo_fs_open(path);
+    int fd = ipo_fs_open_inode(ino);
     if (fd < 0) {
         kfree(binary_image);
-        printf("Failed to open file: %s\n", path);
+        LOG_ERR(LOG_PROC, "Failed to open file: %s\n", path);
         return -4;  // File open failed
     }
     
@@ -194,32 +206,34 @@ static int load_ipob_file(const char *path, ipob_header_t *header_out, void **da
         int bytes_read = ipo_fs_read(fd, (uint8_t*)binary_image + total_read, to_read, total_read);
         
         if (bytes_read <= 0) {
+            ipo_fs_close(fd);
             kfree(binary_image);
-            printf("Read failed at offset %d, read %d bytes\n", total_read, bytes_read);
+            LOG_ERR(LOG_PROC, "Read failed at offset %d, read %d bytes\n", total_read, bytes_read);
             return -4;  // Read failed
         }
         
         total_read += bytes_read;
-        serial_printf("Read chunk: %d bytes, total: %d/%d\n", bytes_read, total_read, stat.size);
+        LOG_TRACE(LOG_PROC, "Read chunk: %d bytes, total: %d/%d\n", bytes_read, total_read, stat.size);
     }
+    ipo_fs_close(fd);
     
     // Parse and check the header
     ipob_header_t *header = (ipob_header_t *)binary_image;
     
     if (memcmp(header->magic, "IPO_B\x00\x00\x00", 8) != 0) {
         kfree(binary_image);
-        printf("Invalid magic in file: %s\n", path);
+        LOG_ERR(LOG_PROC, "Invalid magic in file: %s\n", path);
         return -2;  // Invalid executable format
     }
     
     if (header->entry_offset >= stat.size) {
         kfree(binary_image);
-        printf("Entry offset out of bounds: %d >= %d\n", header->entry_offset, stat.size);
+        LOG_ERR(LOG_PROC, "Entry offset out of bounds: %d >= %d\n", header->entry_offset, stat.size);
         return -2;  // Entry offset out of bounds
     }
     
     if (header->total_size < stat.size) {
-        printf("Warning: header total_size (%d) < actual size (%d)\n", 
+        LOG_WARN(LOG_PROC, "Warning: header total_size (%d) < actual size (%d)\n", 
                header->total_size, stat.size);
     }
     
@@ -229,7 +243,7 @@ static int load_ipob_file(const char *path, ipob_header_t *header_out, void **da
     }
     
     *data_out = binary_image;
-    serial_printf("File loaded successfully\n");
+    LOG_DEBUG(LOG_PROC, "File loaded successfully\n");
     return stat.size;
 }
 
@@ -246,27 +260,30 @@ static int relocate_binary(void *binary, uint32_t load_address, uint32_t size) {
 void process_cleanup(process_t *proc) {
     if (!proc) return;
     
-    serial_printf("Cleaning up process %d\n", proc->pid);
+    LOG_DEBUG(LOG_PROC, "Cleaning up process %d\n", proc->pid);
+    
+    accounting_end(proc);
     
     // Freeing up binary memory
     if (proc->binary_base) {
         free_process_memory(proc->binary_base, proc->binary_size);
     }
     
-    // Freeing arguments
+    // Freeing the ring 3 stack
+    if (proc->user_stack) {
+        kfree(proc->user_stack);
+    }
+    
+    // Freeing arguments: pointer array and strings share one block
     if (proc->argv_kernel) {
-        // argv_kernel contains a pointer to the argv array
-        uint32_t *argv_array = (uint32_t *)proc->argv_kernel;
-        
-        // Freeing up argument structures
-        for (int i = 0; i < proc->argc; i++) {
-            if (argv_array[i]) {
-                kfree((void*)argv_array[i]);
-            }
-        }
-        
-        // Freeing the array itself
-        kfree(argv_array);
+        kfree(proc->argv_kernel);
+    }
+    
+    // Freeing whatever the process allocated and did not free
+    while (proc->blocks) {
+        process_block_t *block = proc->blocks;
+        proc->blocks = block->next;
+        kfree(block);
     }
     
     // Remove from the list of processes
@@ -286,42 +303,128 @@ void process_cleanup(process_t *proc) {
 }
 
 /**
- * process_exec - The main function for executing a process with arguments
+ * run_user_process - Enters ring 3 at the process entry point
+ *
+ * The user stack is laid out as a cdecl call to main(argc, argv) whose
+ * return address is user_exit_trampoline, so returning from main ends
+ * up in SYS_EXIT.
  */
-int process_exec(const char *path, int argc, char **argv) {
+static int run_user_process(process_t *proc, char **argv) {
+    proc->user_stack = kmalloc(PROCESS_USER_STACK_SIZE);
+    if (!proc->user_stack) {
+        LOG_ERR(LOG_PROC, "Failed to allocate user stack\n");
+        return -1;
+    }
+    
+    uint32_t top = (uint32_t)proc->user_stack + PROCESS_USER_STACK_SIZE;
+    proc->stack_start = (uint32_t)proc->user_stack;
+    proc->stack_size = PROCESS_USER_STACK_SIZE;
+    
+    uint32_t *sp = (uint32_t *)(top & ~0xF);
+    *--sp = (uint32_t)argv;
+    *--sp = (uint32_t)proc->argc;
+    *--sp = (uint32_t)user_exit_trampoline;
+    proc->stack_ptr = (uint32_t)sp;
+    
+    // Nested execs from a syscall must not reuse the caller's trap stack
+    uint32_t prev_kernel_stack = syscall_get_kernel_stack();
+    int exit_code = user_mode_enter(proc->entry_point, proc->stack_ptr, &proc->user_ctx);
+    syscall_set_kernel_stack(prev_kernel_stack);
+    
+    return exit_code;
+}
+
+/**
+ * process_exit - Terminates the current ring 3 process
+ *
+ * Returns to the process_exec() that started it. Does nothing when the
+ * current process runs in kernel mode.
+ */
+void process_exit(int exit_code) {
+    process_t *proc = current_process;
+    if (!proc || !proc->user_mode) {
+        return;
+    }
+    
+    LOG_DEBUG(LOG_PROC, "Process %d exited with %d\n", proc->pid, exit_code);
+    user_mode_leave(&proc->user_ctx, exit_code);
+}
+
+/**
+ * process_exec_block - Executes a process, taking ownership of its argument block
+ *
+ * argv_block must come from argv_block_from_cmdline() or argv_block_pack()
+ * (or be NULL); it is freed on every path, so the caller never frees it.
+ * A NULL io inherits the streams of the current process.
+ */
+int process_exec_block(const char *path, int argc, char **argv_block, const process_io_t *io) {
     if (path == NULL) {
+        if (argv_block) kfree(argv_block);
         return -1;
     }
     
-    serial_printf("process_exec: %s, argc=%d\n", path, argc);
+    LOG_DEBUG(LOG_PROC, "process_exec: %s, argc=%d\n", path, argc);
     
     // Creating a process structure
     process_t *proc = kmalloc(sizeof(process_t));
     if (!proc) {
-        printf("Failed to allocate process structure\n");
+        LOG_ERR(LOG_PROC, "Failed to allocate process structure\n");
+        if (argv_block) kfree(argv_block);
         return -2;
     }
     
     memset(proc, 0, sizeof(process_t));
     proc->pid = next_pid++;
     proc->is_running = 1;
+    accounting_begin(proc);
+    
+    if (io) {
+        proc->stdout_sink = io->out ? io->out : sink_console();
+        proc->stdin_pipe = io->in;
+    } else {
+        proc->stdout_sink = process_stdout();
+        proc->stdin_pipe = process_stdin();
+    }
+    
+    // From here on process_cleanup() releases the arguments
+    setup_arguments(proc, argc, argv_block);
     
     // Add to the list of processes
     proc->next = process_list;
     process_list = proc;
     
-    // Uploading the file
+    // Resolve the file once; inode, size and generation identify the cached image
+    uint32_t ino;
+    struct ipo_inode stat;
+    if (!fs_mounted || path_resolve(path, &ino) < 0 || !read_inode(ino, &stat)) {
+        LOG_ERR(LOG_PROC, "File not found: %s\n", path);
+        process_cleanup(proc);
+        return -1;
+    }
+    
     ipob_header_t header;
     void *binary_image;
-    
-    int size = load_ipob_file(path, &header, &binary_image);
-    if (size < 0) {
-        printf("Failed to load file: error %d\n", size);
-        process_cleanup(proc);
-        return size;
+    int size;
+    int owns_image = 0;  // 1 if binary_image must be freed here
+    
+    const void *cached = image_cache_lookup(ino, stat.size, stat.generation);
+    if (cached) {
+        // Already validated: no disk I/O at all
+        binary_image = (void *)cached;
+        size = stat.size;
+        memcpy(&header, cached, IPOB_HEADER_SIZE);
+        LOG_DEBUG(LOG_PROC, "Image cache hit: %s (inode %u)\n", path, ino);
+    } else {
+        size = load_ipob_file(path, ino, &stat, &header, &binary_image);
+        if (size < 0) {
+            LOG_ERR(LOG_PROC, "Failed to load file: error %d\n", size);
+            process_cleanup(proc);
+            return size;
+        }
+        owns_image = !image_cache_insert(ino, stat.size, stat.generation, binary_image);
     }
     
-    serial_printf("File loaded, entry offset: 0x%x, total size: %d\n", 
+    LOG_DEBUG(LOG_PROC, "File loaded, entry offset: 0x%x, total size: %d\n", 
            header.entry_offset, header.total_size);
     
     // Allocating memory at a fixed address
@@ -330,8 +433,8 @@ int process_exec(const char *path, int argc, char **argv) {
                                                PROT_READ | PROT_WRITE | PROT_EXEC);
     
     if (!target_addr) {
-        printf("Failed to allocate memory at 0x%x\n", PROCESS_BASE_ADDR);
-        kfree(binary_image);
+        LOG_ERR(LOG_PROC, "Failed to allocate memory at 0x%x\n", PROCESS_BASE_ADDR);
+        if (owns_image) kfree(binary_image);
         process_cleanup(proc);
         return -5;
     }
@@ -341,17 +444,18 @@ int process_exec(const char *path, int argc, char **argv) {
     
     // Relocate if necessary.
     if (relocate_binary(target_addr, PROCESS_BASE_ADDR, size) < 0) {
-        printf("Relocation failed\n");
+        LOG_ERR(LOG_PROC, "Relocation failed\n");
         free_process_memory(target_addr, size);
-        kfree(binary_image);
+        if (owns_image) kfree(binary_image);
         process_cleanup(proc);
         return -6;
     }
     
-    // Freeing up the temporary buffer
-    kfree(binary_image);
+    // Freeing up the temporary buffer unless the cache kept it
+    if (owns_image) kfree(binary_image);
     
     // Saving information about the process
+    proc->user_mode = (header.flags & IPOB_FLAG_USER) ? 1 : 0;
     proc->binary_base = target_addr;
     proc->binary_size = size;
     // Entry point is relative to where we actually loaded the binary in memory
@@ -360,46 +464,66 @@ int process_exec(const char *path, int argc, char **argv) {
     // Setting up the stack
     proc->stack_ptr = PROCESS_STACK_TOP;
     
-    // Setting up arguments - argv is allocated in kernel memory
-    uint32_t argv_addr = 0;
-    if (setup_arguments(proc, argc, argv, &argv_addr) < 0) {
-        printf("Failed to setup arguments\n");
-        process_cleanup(proc);
-        return -7;
-    }
-    
     // Setting up the stack for calling main()
     setup_stack(proc);
     
-    serial_printf("Process %d ready: entry=0x%x, argc=%d, argv=0x%x\n",
-           proc->pid, proc->entry_point, proc->argc, argv_addr);
+    LOG_DEBUG(LOG_PROC, "Process %d ready: entry=0x%x, argc=%d, argv=0x%x, ring %d\n",
+           proc->pid, proc->entry_point, proc->argc, proc->argv_addr, proc->user_mode ? 3 : 0);
     
     // Save the current process
     process_t *old_process = current_process;
     current_process = proc;
     
     // Call the entry point with arguments
-    serial_printf("Calling entry point with argc=%d, argv at 0x%x...\n", proc->argc, argv_addr);
+    LOG_TRACE(LOG_PROC, "Calling entry point with argc=%d, argv at 0x%x...\n", proc->argc, proc->argv_addr);
     
     // The entry point has a signature: int main(int argc, char **argv)
-    // argv is now a pointer to an array in kernel memory
-    char **argv_ptr = (char**)argv_addr;
+    // argv is the argument block in kernel memory
+    char **argv_ptr = proc->argv_kernel;
+    
+    // The child starts from a clean FPU/SSE state and must not leak into ours
+    sse_save(&proc->caller_fpu);
+    sse_reset();
     
     // Call with arguments
-    typedef int (*entry_func_t)(int, char**);
-    entry_func_t entry_point = (entry_func_t)proc->entry_point;
-    int exit_code = entry_point(proc->argc, argv_ptr);
+    int exit_code;
+    if (proc->user_mode) {
+        exit_code = run_user_process(proc, argv_ptr);
+    } else {
+        ipob_entry_t entry_point = (ipob_entry_t)proc->entry_point;
+        // Their VGA code expects the screen at the start of text memory
+        vga_reset_window();
+        exit_code = entry_point(proc->argc, argv_ptr);
+        // Ring 0 apps drive the screen through their own copy of the VGA code
+        vga_resync_cursor();
+    }
     last_exit_code = exit_code;
+    sse_restore(&proc->caller_fpu);
     
-    serial_printf("Process returned\n");
+    LOG_TRACE(LOG_PROC, "Process returned\n");
     
     // Restoring the old process
     current_process = old_process;
     
     // Cleaning resources
+    uint32_t pid = proc->pid;
     process_cleanup(proc);
     
-    return proc->pid;
+    return pid;
+}
+
+/**
+ * process_exec - Executes a process with a copy of the given arguments
+ */
+int process_exec(const char *path, int argc, char **argv) {
+    int block_argc = 0;
+    char **block = argv_block_pack(argc, argv, &block_argc);
+    if (argc > 0 && argv && argv[0] && !block) {
+        LOG_ERR(LOG_PROC, "Failed to setup arguments\n");
+        return -7;
+    }
+    
+    return process_exec_block(path, block_argc, block, NULL);
 }
 
 /**
@@ -416,6 +540,89 @@ int process_get_exit_code(void) {
     return last_exit_code;
 }
 
+/**
+ * process_get_last_stats - Returns the accounting of the last finished process
+ */
+void process_get_last_stats(process_stats_t *out) {
+    if (out) *out = last_stats;
+}
+
+/**
+ * process_stdout - Returns the stdout of the current process (the console in the kernel)
+ */
+sink_t *process_stdout(void) {
+    return current_process ? current_process->stdout_sink : sink_console();
+}
+
+/**
+ * process_stdin - Returns the stdin pipe of the current process, if any
+ */
+pipe_t *process_stdin(void) {
+    return current_process ? current_process->stdin_pipe : NULL;
+}
+
+/**
+ * process_alloc - Allocates heap memory owned by proc (SYS_MALLOC)
+ *
+ * The block is recorded on the process so that pointers into it pass
+ * process_user_span() and it is released when the process exits.
+ */
+void *process_alloc(process_t *proc, uint32_t size) {
+    if (size == 0 || size > MAX_PROCESS_SIZE) return NULL;
+    
+    process_block_t *block = kmalloc(sizeof(process_block_t) + size);
+    if (!block) return NULL;
+    
+    block->size = size;
+    block->next = proc->blocks;
+    proc->blocks = block;
+    return block + 1;
+}
+
+/**
+ * process_free - Releases a block from process_alloc()
+ *
+ * Returns -1 if ptr is not the start of one of proc's blocks.
+ */
+int process_free(process_t *proc, void *ptr) {
+    for (process_block_t **link = &proc->blocks; *link; link = &(*link)->next) {
+        process_block_t *block = *link;
+        if (block + 1 != ptr) continue;
+        *link = block->next;
+        kfree(block);
+        return 0;
+    }
+    return -1;
+}
+
+/**
+ * process_user_span - Bytes from addr to the end of memory proc may use
+ *
+ * That is the image, the ring 3 stack, the argument block and the
+ * process_alloc() blocks; 0 if addr is in none of them. A block that
+ * matches moves to the front of the list, so a buffer used over and
+ * over is found on the first compare.
+ */
+uint32_t process_user_span(process_t *proc, uint32_t addr) {
+    uint32_t image = (uint32_t)proc->binary_base;
+    uint32_t stack = (uint32_t)proc->user_stack;
+    uint32_t argv = (uint32_t)proc->argv_kernel;
+    if (addr - image < proc->binary_size) return image + proc->binary_size - addr;
+    if (stack && addr - stack < PROCESS_USER_STACK_SIZE) return stack + PROCESS_USER_STACK_SIZE - addr;
+    if (argv && addr - argv < proc->argv_size) return argv + proc->argv_size - addr;
+    
+    for (process_block_t **link = &proc->blocks; *link; link = &(*link)->next) {
+        process_block_t *block = *link;
+        uint32_t start = (uint32_t)(block + 1);
+        if (addr - start >= block->size) continue;
+        *link = block->next;
+        block->next = proc->blocks;
+        proc->blocks = block;
+        return start + block->size - addr;
+    }
+    return 0;
+}
+
 /**
  * process_get_current - Returns the current process
  */
@@ -0,0 +1,123 @@
+#include <kernel/scrollback.h>
+#include <vga.h>
+
+// Largest payload: every cell in its own run
+#define MAX_PAYLOAD (VGA_WIDTH * 3)
+
+static uint8_t ring[SCROLLBACK_BYTES];
+static uint32_t ring_head = 0;   // Where the next record starts
+static uint32_t ring_tail = 0;   // Oldest record
+static uint32_t ring_used = 0;
+static int line_count = 0;
+
+static inline uint32_t ring_pos(uint32_t pos) {
+    return pos % SCROLLBACK_BYTES;
+}
+
+static inline uint8_t ring_get(uint32_t pos) {
+    return ring[ring_pos(pos)];
+}
+
+/* A cell that decodes back to the same blank on screen */
+static inline int is_blank(uint16_t cell) {
+    uint8_t c = cell & 0xFF;
+    uint8_t bg = (cell >> 12) & 0x0F;
+    return (c == 0x00 || c == ' ') && bg == VGA_COLOR_BLACK;
+}
+
+void scrollback_clear(void) {
+    ring_head = ring_tail = ring_used = 0;
+    line_count = 0;
+}
+
+/**
+ * encode_line - Builds the run list for one line
+ * Returns the payload length.
+ */
+static uint32_t encode_line(const volatile uint16_t *cells, uint8_t *out) {
+    int width = VGA_WIDTH;
+    while (width > 0 && is_blank(cells[width - 1])) width--;
+    
+    uint32_t len = 0;
+    int col = 0;
+    while (col < width) {
+        uint8_t attr = cells[col] >> 8;
+        uint32_t count_at = len + 1;
+        out[len] = attr;
+        len += 2;
+        
+        uint8_t count = 0;
+        while (col < width && (uint8_t)(cells[col] >> 8) == attr) {
+            out[len++] = cells[col] & 0xFF;
+            count++;
+            col++;
+        }
+        out[count_at] = count;
+    }
+    return len;
+}
+
+static void evict_oldest(void) {
+    uint32_t size = (uint32_t)ring_get(ring_tail) + 2;
+    ring_tail = ring_pos(ring_tail + size);
+    ring_used -= size;
+    line_count--;
+}
+
+void scrollback_push(const volatile uint16_t *cells) {
+    uint8_t payload[MAX_PAYLOAD];
+    uint32_t len = encode_line(cells, payload);
+    uint32_t size = len + 2;
+    
+    while (ring_used + size > SCROLLBACK_BYTES) {
+        evict_oldest();
+    }
+    
+    ring[ring_head] = (uint8_t)len;
+    for (uint32_t i = 0; i < len; i++) {
+        ring[ring_pos(ring_head + 1 + i)] = payload[i];
+    }
+    ring[ring_pos(ring_head + 1 + len)] = (uint8_t)len;
+    
+    ring_head = ring_pos(ring_head + size);
+    ring_used += size;
+    line_count++;
+}
+
+int scrollback_count(void) {
+    return line_count;
+}
+
+uint32_t scrollback_older(uint32_t pos) {
+    uint32_t len = ring_get(pos + SCROLLBACK_BYTES - 1);
+    return ring_pos(pos + SCROLLBACK_BYTES - (len + 2));
+}
+
+uint32_t scrollback_find(int age) {
+    uint32_t pos = scrollback_older(ring_head);
+    for (int i = 0; i < age; i++) {
+        pos = scrollback_older(pos);
+    }
+    return pos;
+}
+
+void scrollback_decode(uint32_t pos, uint16_t *cells) {
+    uint32_t len = ring_get(pos);
+    uint32_t p = pos + 1;
+    uint32_t end = p + len;
+    int col = 0;
+    
+    while (p < end && col < VGA_WIDTH) {
+        uint16_t attr = (uint16_t)ring_get(p) << 8;
+        uint8_t count = ring_get(p + 1);
+        p += 2;
+        for (uint8_t i = 0; i < count && col < VGA_WIDTH; i++) {
+            cells[col++] = attr | ring_get(p++);
+        }
+    }
+    
+    uint16_t blank = vga_entry(0x00, VGA_COLOR_WHITE, VGA_COLOR_BLACK);
+    while (col < VGA_WIDTH) {
+        cells[col++] = blank;
+    }
+}
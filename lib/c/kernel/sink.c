@@ -0,0 +1,148 @@
+#include <kernel/sink.h>
+#include <file_system/ipo_fs.h>
+#include <memory/kmalloc.h>
+#include <string.h>
+#include <stdio.h>
+
+static sink_t console_sink = { .type = SINK_CONSOLE };
+static sink_t serial_sink = { .type = SINK_SERIAL };
+
+sink_t *sink_console(void) {
+    return &console_sink;
+}
+
+sink_t *sink_serial(void) {
+    return &serial_sink;
+}
+
+void sink_init_pipe(sink_t *sink, pipe_t *pipe) {
+    memset(sink, 0, sizeof(*sink));
+    sink->type = SINK_PIPE;
+    sink->pipe = pipe;
+}
+
+bool sink_open_file(sink_t *sink, const char *path, bool append) {
+    memset(sink, 0, sizeof(*sink));
+    sink->type = SINK_FILE;
+    sink->fd = -1;
+    
+    struct ipo_inode stat;
+    bool exists = ipo_fs_stat(path, &stat);
+    if (exists && (stat.mode & IPO_INODE_TYPE_DIR)) {
+        printf("%s: is a directory\n", path);
+        return false;
+    }
+    
+    // Truncate by recreating the file
+    if (exists && !append) {
+        if (!ipo_fs_delete(path)) return false;
+        exists = false;
+    }
+    if (!exists && ipo_fs_create(path, IPO_INODE_TYPE_FILE) < 0) {
+        return false;
+    }
+    
+    sink->fd = ipo_fs_open(path);
+    if (sink->fd < 0) return false;
+    sink->file_offset = exists ? stat.size : 0;
+    return true;
+}
+
+/**
+ * file_sink_reserve - Grows the memory buffer of a file sink to fit extra bytes
+ */
+static bool file_sink_reserve(sink_t *sink, uint32_t extra) {
+    uint32_t needed = sink->len + extra;
+    if (needed <= sink->cap) return true;
+    
+    uint32_t cap = sink->cap ? sink->cap : SINK_FILE_INITIAL_SIZE;
+    while (cap < needed) cap *= 2;
+    
+    uint8_t *buf = kmalloc(cap);
+    if (!buf) return false;
+    memcpy(buf, sink->buf, sink->len);
+    kfree(sink->buf);
+    sink->buf = buf;
+    sink->cap = cap;
+    return true;
+}
+
+/**
+ * pipe_sink_write - Stages small writes, passes large ones straight through
+ */
+static int pipe_sink_write(sink_t *sink, const void *buf, uint32_t len) {
+    // A full pipe counts what it drops, so a short flush is not an error here
+    if (sink->staged + len > SINK_BUFFER_SIZE) {
+        sink_flush(sink);
+    }
+    if (len >= SINK_BUFFER_SIZE) {
+        return pipe_write(sink->pipe, buf, len);
+    }
+    
+    memcpy(sink->stage + sink->staged, buf, len);
+    sink->staged += len;
+    return (int)len;
+}
+
+int sink_write(sink_t *sink, const void *buf, uint32_t len) {
+    if (!sink || !buf) return -1;
+    
+    switch (sink->type) {
+        case SINK_CONSOLE:
+            console_write((const char *)buf, len);
+            return (int)len;
+        case SINK_SERIAL:
+            serial_write((const char *)buf, len);
+            return (int)len;
+        case SINK_PIPE:
+            return pipe_sink_write(sink, buf, len);
+        case SINK_FILE:
+            if (sink->fd < 0 || !file_sink_reserve(sink, len)) return -1;
+            memcpy(sink->buf + sink->len, buf, len);
+            sink->len += len;
+            return (int)len;
+    }
+    return -1;
+}
+
+static void format_sink_write(format_sink_t *fmt, const char *buf, size_t len) {
+    sink_write((sink_t *)fmt->ctx, buf, len);
+}
+
+int sink_printf(sink_t *sink, const char *format, ...) {
+    format_sink_t fmt = { format_sink_write, sink };
+    va_list args;
+    va_start(args, format);
+    int count = vformat(&fmt, format, args);
+    va_end(args);
+    return count;
+}
+
+bool sink_flush(sink_t *sink) {
+    if (!sink || sink->type != SINK_PIPE || sink->staged == 0) return true;
+    
+    int written = pipe_write(sink->pipe, sink->stage, sink->staged);
+    bool ok = written == (int)sink->staged;
+    sink->staged = 0;
+    return ok;
+}
+
+bool sink_close(sink_t *sink) {
+    if (!sink) return true;
+    if (sink->type == SINK_PIPE) return sink_flush(sink);
+    if (sink->type != SINK_FILE) return true;
+    
+    bool ok = true;
+    if (sink->fd >= 0) {
+        if (sink->len > 0) {
+            int written = ipo_fs_write(sink->fd, sink->buf, sink->len, sink->file_offset);
+            ok = written == (int)sink->len;
+        }
+        ipo_fs_close(sink->fd);
+        sink->fd = -1;
+    }
+    kfree(sink->buf);
+    sink->buf = NULL;
+    sink->len = sink->cap = 0;
+    return ok;
+}
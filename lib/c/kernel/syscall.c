@@ -0,0 +1,183 @@
+#include <kernel/syscall.h>
+#include <kernel/process.h>
+#include <file_system/ipo_fs.h>
+#include <memory/kmalloc.h>
+#include <system/idt.h>
+#include <system/gdt.h>
+#include <system/cpu.h>
+#include <system/tsc.h>
+#include <stdio.h>
+
+typedef int32_t (*syscall_fn_t)(uint32_t arg1, uint32_t arg2, uint32_t arg3, uint32_t arg4);
+
+static int sysenter_available = 0;
+
+/*
+ * Pointer checks against the memory of the current process (see
+ * process_user_span). There is no paging, so this only keeps a stray
+ * pointer from faulting or scribbling over the kernel.
+ * Ring 0 callers share the kernel's memory and are trusted.
+ */
+static int user_range_ok(uint32_t addr, uint32_t len) {
+    process_t *proc = process_get_current();
+    if (!proc || !proc->user_mode) return addr != 0;
+    uint32_t span = process_user_span(proc, addr);
+    return span != 0 && len <= span;
+}
+
+/* The NUL must come before the end of the memory the string starts in */
+static int user_string_ok(uint32_t addr) {
+    process_t *proc = process_get_current();
+    if (!proc || !proc->user_mode) return addr != 0;
+    const char *s = (const char *)addr;
+    for (uint32_t i = 0, span = process_user_span(proc, addr); i < span; i++) {
+        if (s[i] == '\0') return 1;
+    }
+    return 0;
+}
+
+/* argv is read up to argc entries or the first NULL, as argv_block_pack does */
+static int user_argv_ok(uint32_t argv, uint32_t argc) {
+    if (argc == 0 || !argv) return 1;
+    if (argc > MAX_ARGV_COUNT) argc = MAX_ARGV_COUNT;
+    if (!user_range_ok(argv, argc * sizeof(char *))) return 0;
+    const uint32_t *entries = (const uint32_t *)argv;
+    for (uint32_t i = 0; i < argc && entries[i]; i++) {
+        if (!user_string_ok(entries[i])) return 0;
+    }
+    return 1;
+}
+
+static int32_t sys_exit(uint32_t code, uint32_t a2, uint32_t a3, uint32_t a4) {
+    process_exit((int)code);
+    return -1;  /* only reached when no ring 3 process is running */
+}
+
+static int32_t sys_console_write(uint32_t buf, uint32_t len, uint32_t a3, uint32_t a4) {
+    if (!user_range_ok(buf, len)) return -1;
+    return sink_write(process_stdout(), (const void *)buf, len);
+}
+
+static int32_t sys_open(uint32_t path, uint32_t a2, uint32_t a3, uint32_t a4) {
+    if (!user_string_ok(path)) return -1;
+    return ipo_fs_open((const char *)path);
+}
+
+static int32_t sys_close(uint32_t fd, uint32_t a2, uint32_t a3, uint32_t a4) {
+    return ipo_fs_close((int)fd) ? 0 : -1;
+}
+
+static int32_t sys_read(uint32_t fd, uint32_t buf, uint32_t size, uint32_t offset) {
+    if (!user_range_ok(buf, size)) return -1;
+    return ipo_fs_read((int)fd, (void *)buf, size, offset);
+}
+
+static int32_t sys_write(uint32_t fd, uint32_t buf, uint32_t size, uint32_t offset) {
+    if (!user_range_ok(buf, size)) return -1;
+    return ipo_fs_write((int)fd, (const void *)buf, size, offset);
+}
+
+static int32_t sys_stat(uint32_t path, uint32_t out, uint32_t a3, uint32_t a4) {
+    if (!user_string_ok(path) || !user_range_ok(out, sizeof(struct ipo_inode))) return -1;
+    return ipo_fs_stat((const char *)path, (struct ipo_inode *)out) ? 0 : -1;
+}
+
+static int32_t sys_malloc(uint32_t size, uint32_t a2, uint32_t a3, uint32_t a4) {
+    process_t *proc = process_get_current();
+    return (int32_t)(proc ? process_alloc(proc, size) : kmalloc(size));
+}
+
+static int32_t sys_free(uint32_t ptr, uint32_t a2, uint32_t a3, uint32_t a4) {
+    if (!ptr) return 0;
+    process_t *proc = process_get_current();
+    if (proc) return process_free(proc, (void *)ptr);
+    kfree((void *)ptr);
+    return 0;
+}
+
+static int32_t sys_getpid(uint32_t a1, uint32_t a2, uint32_t a3, uint32_t a4) {
+    process_t *proc = process_get_current();
+    return proc ? (int32_t)proc->pid : 0;
+}
+
+static int32_t sys_exec(uint32_t path, uint32_t argc, uint32_t argv, uint32_t a4) {
+    if (!user_string_ok(path) || !user_argv_ok(argv, argc)) return -1;
+    int result = process_exec((const char *)path, (int)argc, (char **)argv);
+    return result < 0 ? result : process_get_exit_code();
+}
+
+static int32_t sys_stdin_read(uint32_t buf, uint32_t len, uint32_t a3, uint32_t a4) {
+    if (!user_range_ok(buf, len)) return -1;
+    pipe_t *in = process_stdin();
+    return in ? pipe_read(in, (void *)buf, len) : 0;
+}
+
+static int32_t sys_tsc_khz(uint32_t a1, uint32_t a2, uint32_t a3, uint32_t a4) {
+    return (int32_t)tsc_get_khz();
+}
+
+static int32_t sys_create(uint32_t path, uint32_t type, uint32_t a3, uint32_t a4) {
+    if (!user_string_ok(path)) return -1;
+    return ipo_fs_create((const char *)path, (uint8_t)type);
+}
+
+static int32_t sys_delete(uint32_t path, uint32_t a2, uint32_t a3, uint32_t a4) {
+    if (!user_string_ok(path)) return -1;
+    return ipo_fs_delete((const char *)path) ? 0 : -1;
+}
+
+static const syscall_fn_t syscall_table[SYS_COUNT] = {
+    [SYS_EXIT]          = sys_exit,
+    [SYS_CONSOLE_WRITE] = sys_console_write,
+    [SYS_OPEN]          = sys_open,
+    [SYS_CLOSE]         = sys_close,
+    [SYS_READ]          = sys_read,
+    [SYS_WRITE]         = sys_write,
+    [SYS_STAT]          = sys_stat,
+    [SYS_MALLOC]        = sys_malloc,
+    [SYS_FREE]          = sys_free,
+    [SYS_GETPID]        = sys_getpid,
+    [SYS_EXEC]          = sys_exec,
+    [SYS_STDIN_READ]    = sys_stdin_read,
+    [SYS_TSC_KHZ]       = sys_tsc_khz,
+    [SYS_CREATE]        = sys_create,
+    [SYS_DELETE]        = sys_delete,
+};
+
+int32_t syscall_dispatch(uint32_t number, uint32_t arg1, uint32_t arg2, uint32_t arg3, uint32_t arg4) {
+    if (number >= SYS_COUNT || !syscall_table[number]) {
+        return -1;
+    }
+    return syscall_table[number](arg1, arg2, arg3, arg4);
+}
+
+void syscall_set_kernel_stack(uint32_t esp0) {
+    tss_set_kernel_stack(esp0);
+    if (sysenter_available) {
+        cpu_wrmsr(MSR_SYSENTER_ESP, esp0, 0);
+    }
+}
+
+uint32_t syscall_get_kernel_stack(void) {
+    return tss_get_kernel_stack();
+}
+
+int syscall_has_sysenter(void) {
+    return sysenter_available;
+}
+
+/**
+ * syscall_init - Install the int 0x80 gate and the SYSENTER fast path
+ */
+void syscall_init(void) {
+    idt_set_gate(SYSCALL_VECTOR, (uint32_t)syscall_int80_entry, IDT_GATE_INTERRUPT_USER);
+
+    sysenter_available = cpu_has_feature_edx(CPUID_EDX_SEP | CPUID_EDX_MSR) ? 1 : 0;
+    if (sysenter_available) {
+        cpu_wrmsr(MSR_SYSENTER_CS, GDT_KERNEL_CODE, 0);
+        cpu_wrmsr(MSR_SYSENTER_ESP, tss_get_kernel_stack(), 0);
+        cpu_wrmsr(MSR_SYSENTER_EIP, (uint32_t)syscall_sysenter_entry, 0);
+    }
+
+    printf("Syscalls: int 0x%x%s\n", SYSCALL_VECTOR, sysenter_available ? " + sysenter" : "");
+}
@@ -5,7 +5,17 @@
 #include <driver/input/keymap/keymap.h>
 #include <file_system/ipo_fs.h>
 #include <kernel/process.h>
+#include <kernel/argv.h>
+#include <kernel/scrollback.h>
+#include <kernel/log.h>
+#include <kernel/boot_info.h>
+#include <kernel/boot_timeline.h>
+#include <kernel/ntbench.h>
 #include <memory/kmalloc.h>
+#include <system/tsc.h>
+#include <system/cpu.h>
+#include <driver/serial.h>
+#include <ioport.h>
 
 #include <stdint.h>
 #include <stdbool.h>
@@ -24,10 +34,14 @@
 #define PROMPT_FG VGA_COLOR_LIGHT_GREEN
 #define INPUT_FG VGA_COLOR_LIGHT_GREY
 
-/* Terminal Buffers - each can store multiple lines of history */
-#define SCROLL_HISTORY_SIZE 1024  // Number of lines to store in history
-static uint16_t terminal_top_buffer[SCROLL_HISTORY_SIZE][VGA_WIDTH];
-static uint16_t terminal_bottom_buffer[SCROLL_HISTORY_SIZE][VGA_WIDTH];
+/* Scroll the terminal by moving the CRTC start address instead of copying */
+#define TERMINAL_HW_SCROLL 1
+
+/* Live screen saved while the view shows history */
+static uint16_t terminal_live_snapshot[VGA_HEIGHT][VGA_WIDTH];
+
+/* File system blocks lazily initialised per idle keyboard poll */
+#define FS_IDLE_INIT_BLOCKS 8
 
 /* Input buffer for simple command handling */
 #define INPUT_BUF_SIZE 256
@@ -37,8 +51,7 @@ static int input_len = 0;
 static bool prompt_shown = false;
 
 /* Scroll state */
-static int top_buffer_count = 0;      // How many lines are stored in terminal_top_buffer
-static int bottom_buffer_count = 0;   // How many lines are stored in terminal_bottom_buffer
+static int view_offset = 0;      // Lines scrolled back from the present (0 = live)
 
 // Terminal drawing area (below header)
 static inline uint16_t terminal_top_row(void) {
@@ -101,29 +114,78 @@ static void write_line_to_vga(uint16_t row, const uint16_t *buffer) {
     }
 }
 
+/* Draw the terminal area for the current view offset */
+static void redraw_view(void) {
+    uint16_t top = terminal_top_row();
+    uint16_t rows = terminal_rows();
+    int history_count = scrollback_count();
+    uint16_t line_buf[VGA_WIDTH];
+    
+    // Virtual lines: the history, oldest first, followed by the live screen
+    int first = history_count - view_offset;
+    
+    // Live rows at the bottom of the view
+    int history_rows = view_offset < rows ? view_offset : rows;
+    for (uint16_t r = history_rows; r < rows; r++) {
+        write_line_to_vga(top + r, terminal_live_snapshot[first + r - history_count]);
+    }
+    
+    // History rows, decoded from the newest visible one upward
+    if (history_rows == 0) return;
+    uint32_t pos = scrollback_find(history_count - 1 - (first + history_rows - 1));
+    for (int r = history_rows - 1; r >= 0; r--) {
+        scrollback_decode(pos, line_buf);
+        write_line_to_vga(top + r, line_buf);
+        if (r > 0) pos = scrollback_older(pos);
+    }
+}
+
+static void return_to_present(void);
+
+#if TERMINAL_HW_SCROLL
+/*
+ * Scroll the terminal area by panning the visible window one row down
+ * through text memory. The header rows move with the window, so they are
+ * copied back on top of it; the rest of the screen needs no copying until
+ * the window reaches the end of text memory and wraps to the start.
+ */
+static void hw_scroll_line(void) {
+    uint16_t header[VGA_START_CURSOR_POSITION];
+    volatile uint16_t *vga = VGA_MEMORY;
+    
+    for (uint16_t i = 0; i < VGA_START_CURSOR_POSITION; i++) {
+        header[i] = vga[i];
+    }
+    
+    uint16_t start = vga_get_window();
+    if (start + (VGA_HEIGHT + 1) * VGA_WIDTH > VGA_TEXT_CELLS) {
+        vga_reset_window();
+        start = 0;
+    }
+    vga_set_window(start + VGA_WIDTH);
+    
+    vga = VGA_MEMORY;
+    for (uint16_t i = 0; i < VGA_START_CURSOR_POSITION; i++) {
+        vga[i] = header[i];
+    }
+}
+#endif
+
 /* Auto scroll when terminal overflows - called by putchar/printf when needed */
 void terminal_auto_scroll(void) {
     volatile uint16_t* vga = VGA_MEMORY;
     uint16_t top = terminal_top_row();
     uint16_t rows = terminal_rows();
     
-    // Save the TOP line (which will disappear) to top_buffer history before shifting
-    if (top_buffer_count < SCROLL_HISTORY_SIZE) {
-        read_line_from_vga(top, terminal_top_buffer[top_buffer_count]);
-        top_buffer_count++;
-     } else {
-        // Buffer is full, shift all lines and add new at end
-        for (int i = 0; i < SCROLL_HISTORY_SIZE - 1; i++) {
-            for (uint16_t c = 0; c < VGA_WIDTH; c++) {
-                terminal_top_buffer[i][c] = terminal_top_buffer[i + 1][c];
-            }
-        }
-        read_line_from_vga(top, terminal_top_buffer[SCROLL_HISTORY_SIZE - 1]);
-    }
+    // New output scrolls the live screen, not the history being viewed
+    return_to_present();
     
-    // Reset bottom buffer since we got new output
-    bottom_buffer_count = 0;
+    // Save the TOP line (which will disappear) into the scrollback
+    scrollback_push(vga + top * VGA_WIDTH);
     
+#if TERMINAL_HW_SCROLL
+    hw_scroll_line();
+#else
     // Shift lines up by one
     for (uint16_t r = 0; r < rows - 1; r++) {
         uint16_t src_offset = (top + r + 1) * VGA_WIDTH;
@@ -133,9 +195,11 @@ void terminal_auto_scroll(void) {
             vga[dst_offset + c] = vga[src_offset + c];
         }
     }
+#endif
     
     // Clear bottom line
     uint16_t blank = vga_entry(0x00, VGA_COLOR_WHITE, VGA_COLOR_BLACK);
+    vga = VGA_MEMORY;
     for (uint16_t c = 0; c < VGA_WIDTH; c++) {
         vga[(top + rows - 1) * VGA_WIDTH + c] = blank;
     }
@@ -143,108 +207,49 @@ void terminal_auto_scroll(void) {
 
 /* Return to present - restore current output when user starts typing */
 static void return_to_present(void) {
-    // If we're in history, restore to the present
-    if (bottom_buffer_count == 0) {
+    if (view_offset == 0) {
         return;  // Already at present
     }
     
-    volatile uint16_t* vga = VGA_MEMORY;
-    uint16_t top = terminal_top_row();
-    uint16_t rows = terminal_rows();
-    
-    // Restore all lines from bottom_buffer by scrolling down (reverse of scroll up)
-    while (bottom_buffer_count > 0) {
-        // Save the current top line to top_buffer
-        read_line_from_vga(top, terminal_top_buffer[top_buffer_count]);
-        top_buffer_count++;
-        
-        // Shift lines up by one (move forward in time)
-        for (uint16_t r = 0; r < rows - 1; r++) {
-            uint16_t src_offset = (top + r + 1) * VGA_WIDTH;
-            uint16_t dst_offset = (top + r) * VGA_WIDTH;
-            
-            for (uint16_t c = 0; c < VGA_WIDTH; c++) {
-                vga[dst_offset + c] = vga[src_offset + c];
-            }
-        }
-        
-        // Restore line from bottom_buffer at the bottom (move toward present)
-        write_line_to_vga(top + rows - 1, terminal_bottom_buffer[bottom_buffer_count - 1]);
-        bottom_buffer_count--;
-    }
+    view_offset = 0;
+    redraw_view();
     
     // Show cursor when returning to present
     vga_show_cursor();
 }
 
-/* Scroll down - restore next line from history if available */
+/* Scroll down - move the view one line toward the present */
 static void scroll_down(void) {
-    // Can only scroll down if we're in scroll history (in the past)
-    if (bottom_buffer_count == 0) {
+    if (view_offset == 0) {
         return;  // Can't scroll further, we're at the current output
     }
     
-    volatile uint16_t* vga = VGA_MEMORY;
-    uint16_t top = terminal_top_row();
-    uint16_t rows = terminal_rows();
-    
-    // Save the current top line to top_buffer
-    read_line_from_vga(top, terminal_top_buffer[top_buffer_count]);
-    top_buffer_count++;
+    view_offset--;
+    redraw_view();
     
-    // Shift lines up by one (move forward in time)
-    for (uint16_t r = 0; r < rows - 1; r++) {
-        uint16_t src_offset = (top + r + 1) * VGA_WIDTH;
-        uint16_t dst_offset = (top + r) * VGA_WIDTH;
-        
-        for (uint16_t c = 0; c < VGA_WIDTH; c++) {
-            vga[dst_offset + c] = vga[src_offset + c];
-        }
-    }
-    
-    // Restore line from bottom_buffer at the bottom (move toward present)
-    write_line_to_vga(top + rows - 1, terminal_bottom_buffer[bottom_buffer_count - 1]);
-    bottom_buffer_count--;
-    
-    // Show cursor when we return to present (bottom_buffer is now empty)
-    if (bottom_buffer_count == 0) {
+    // Show cursor when we return to present
+    if (view_offset == 0) {
         vga_show_cursor();
     }
 }
 
 /* Scroll up - show previous line from history */
 static void scroll_up(void) {
-    // Only scroll up if we have history to go back to
-    if (top_buffer_count == 0) {
+    if (view_offset >= scrollback_count()) {
         return;  // Nothing to scroll back to
     }
     
-    volatile uint16_t* vga = VGA_MEMORY;
-    uint16_t top = terminal_top_row();
-    uint16_t rows = terminal_rows();
-    
-    // Hide cursor when entering history
-    vga_hide_cursor();
-    
-    // Save the current bottom line to bottom_buffer before shifting
-    if (bottom_buffer_count < SCROLL_HISTORY_SIZE) {
-        read_line_from_vga(top + rows - 1, terminal_bottom_buffer[bottom_buffer_count]);
-        bottom_buffer_count++;
-    }
-    
-    // Shift lines down by one
-    for (uint16_t r = rows - 1; r > 0; r--) {
-        uint16_t src_offset = (top + r - 1) * VGA_WIDTH;
-        uint16_t dst_offset = (top + r) * VGA_WIDTH;
-        
-        for (uint16_t c = 0; c < VGA_WIDTH; c++) {
-            vga[dst_offset + c] = vga[src_offset + c];
+    // Entering history: keep the live screen to come back to
+    if (view_offset == 0) {
+        uint16_t top = terminal_top_row();
+        for (uint16_t r = 0; r < terminal_rows(); r++) {
+            read_line_from_vga(top + r, terminal_live_snapshot[r]);
         }
+        vga_hide_cursor();
     }
     
-    // Restore line from top_buffer at the top (go back in history)
-    write_line_to_vga(top, terminal_top_buffer[top_buffer_count - 1]);
-    top_buffer_count--;
+    view_offset++;
+    redraw_view();
 }
 
 char* resolve_command_path(const char *cmd) {
@@ -278,7 +283,7 @@ char* resolve_command_path(const char *cmd) {
     
     // Try to resolve and verify it's a file (not directory)
     if (path_resolve(canonical, &inode) == 0 && 
-        ipo_fs_stat(canonical, &stat) && 
+        read_inode(inode, &stat) && 
         (stat.mode & IPO_INODE_TYPE_DIR) == 0) {
         strncpy(path, canonical, 255);
         path[255] = '\0';
@@ -294,10 +299,8 @@ void terminal_initialize(void) {
 
     print_header();
 
-    terminal_top_buffer[0][0] = 0;
-    terminal_bottom_buffer[0][0] = 0;
-    top_buffer_count = 0;
-    bottom_buffer_count = 0;
+    scrollback_clear();
+    view_offset = 0;
     input_len = 0;
     prompt_shown = false;
 }
@@ -308,85 +311,364 @@ static void print_prompt(void) {
     prompt_shown = true;
 }
 
-int try_execute_command(const char *cmdline) {
-    if (!cmdline) return -1;
+/* Pipelines */
+#define MAX_PIPELINE_STAGES 8
+#define SERIAL_DEVICE_PATH "/dev/serial"  // Redirection target for COM1
+
+/* Builtins run inside the kernel and return like try_execute_command */
+typedef int (*builtin_handler_t)(const char *args, const process_io_t *io);
+
+typedef struct {
+    const char *name;
+    builtin_handler_t handler;
+} builtin_t;
+
+static int builtin_time(const char *args, const process_io_t *io);
+static int builtin_loglevel(const char *args, const process_io_t *io);
+static int builtin_poweroff(const char *args, const process_io_t *io);
+static int builtin_bootinfo(const char *args, const process_io_t *io);
+static int builtin_boottime(const char *args, const process_io_t *io);
+static int builtin_ntbench(const char *args, const process_io_t *io);
+static int execute_stage(const char *cmdline, const process_io_t *io);
+
+static const builtin_t builtins[] = {
+    { "time", builtin_time },
+    { "loglevel", builtin_loglevel },
+    { "poweroff", builtin_poweroff },
+    { "bootinfo", builtin_bootinfo },
+    { "boottime", builtin_boottime },
+    { "ntbench", builtin_ntbench },
+};
+
+#define BUILTIN_COUNT (sizeof(builtins) / sizeof(builtins[0]))
+
+static const builtin_t *find_builtin(const char *name) {
+    for (size_t i = 0; i < BUILTIN_COUNT; i++) {
+        if (strcmp(builtins[i].name, name) == 0) return &builtins[i];
+    }
+    return NULL;
+}
 
-    // Extract command name (first token)
+/* Skip the first token of a command line and the blanks after it */
+static const char *skip_command_name(const char *cmdline) {
+    while (*cmdline == ' ' || *cmdline == '\t') cmdline++;
+    while (*cmdline && *cmdline != ' ' && *cmdline != '\t') cmdline++;
     while (*cmdline == ' ' || *cmdline == '\t') cmdline++;
-    if (*cmdline == '\0') return 0;
+    return cmdline;
+}
 
-    char name[128];
-    int i = 0;
-    while (*cmdline && *cmdline != ' ' && *cmdline != '\t' && i < (int)sizeof(name)-1) {
-        name[i++] = *cmdline++;
+/* Copy the next blank-separated word into out (truncated); returns the rest */
+static const char *next_word(const char *s, char *out, size_t size) {
+    size_t n = 0;
+    while (*s == ' ' || *s == '\t') s++;
+    while (*s && *s != ' ' && *s != '\t') {
+        if (n < size - 1) out[n++] = *s;
+        s++;
     }
-    name[i] = '\0';
+    out[n] = '\0';
+    return s;
+}
 
-    // Resolve to filesystem path
-    char *path = resolve_command_path(name);
-    if (!path) return 0; // not found
+/* Print microseconds as milliseconds with three decimals */
+static void print_ms(sink_t *out, uint64_t us) {
+    uint32_t frac = (uint32_t)(us % 1000);
+    sink_printf(out, "%u.%c%c%c ms", (uint32_t)(us / 1000),
+                '0' + frac / 100, '0' + (frac / 10) % 10, '0' + frac % 10);
+}
 
-    // Parse arguments from the remaining part of cmdline
-    char *argv[32];  // Support up to 32 arguments
-    int argc = 0;
-    argv[argc++] = name;  // First argument is program name
-    
-    // Skip whitespace after command name
-    while (*cmdline && (*cmdline == ' ' || *cmdline == '\t')) cmdline++;
-    
-    // Parse remaining arguments
-    char arg_buf[512];  // Temporary buffer for arguments
-    int arg_pos = 0;
-    int in_arg = 0;
-    
-    while (*cmdline && argc < 31) {  // Leave room for NULL terminator
-        if (*cmdline == ' ' || *cmdline == '\t') {
-            if (in_arg) {
-                // End current argument
-                arg_buf[arg_pos] = '\0';
-                char *arg_copy = kmalloc(arg_pos + 1);
-                if (arg_copy) {
-                    strcpy(arg_copy, arg_buf);
-                    argv[argc++] = arg_copy;
-                }
-                arg_pos = 0;
-                in_arg = 0;
-            }
-            cmdline++;
-        } else {
-            // Add character to current argument
-            if (arg_pos < (int)sizeof(arg_buf) - 1) {
-                arg_buf[arg_pos++] = *cmdline;
-                in_arg = 1;
-            }
-            cmdline++;
-        }
+/**
+ * builtin_time - Runs a command and reports its cycles, disk I/O and heap use
+ */
+static int builtin_time(const char *args, const process_io_t *io) {
+    if (*args == '\0') {
+        sink_printf(io->out, "usage: time <command> [args...]\n");
+        return -1;
     }
     
-    // Handle last argument
-    if (in_arg) {
-        arg_buf[arg_pos] = '\0';
-        char *arg_copy = kmalloc(arg_pos + 1);
-        if (arg_copy) {
-            strcpy(arg_copy, arg_buf);
-            argv[argc++] = arg_copy;
+    int result = execute_stage(args, io);
+    if (result <= 0) return result;
+    
+    process_stats_t st;
+    process_get_last_stats(&st);
+    uint64_t cycles = st.end_cycles - st.start_cycles;
+    
+    sink_printf(io->out, "real    ");
+    if (tsc_get_khz()) {
+        print_ms(io->out, tsc_cycles_to_us(cycles));
+    } else {
+        sink_printf(io->out, "n/a");
+    }
+    sink_printf(io->out, "\ncycles  %llu\n", cycles);
+    sink_printf(io->out, "disk    %u sectors read (%u cmds), %u written (%u cmds)\n",
+                st.sectors_read, st.read_commands, st.sectors_written, st.write_commands);
+    sink_printf(io->out, "heap    %u bytes peak\n", st.peak_heap);
+    
+    return result;
+}
+
+/**
+ * builtin_loglevel - Shows or sets the run-time log level of each subsystem
+ * Usage: loglevel [<subsystem>|all <level>]
+ */
+static int builtin_loglevel(const char *args, const process_io_t *io) {
+    char sub_name[16];
+    char level_name[16];
+    args = next_word(args, sub_name, sizeof(sub_name));
+    next_word(args, level_name, sizeof(level_name));
+    
+    if (sub_name[0] == '\0') {
+        for (int i = 0; i < LOG_SUBSYSTEM_COUNT; i++) {
+            sink_printf(io->out, "%-8s %s\n", log_subsystem_name(i), log_level_name(log_levels[i]));
         }
+        sink_printf(io->out, "compiled up to %s\n", log_level_name(LOG_COMPILE_LEVEL));
+        return 1;
+    }
+    
+    int level = log_parse_level(level_name);
+    int sub = strcmp(sub_name, "all") == 0 ? LOG_SUBSYSTEM_COUNT : log_find_subsystem(sub_name);
+    if (level < 0 || sub < 0) {
+        sink_printf(io->out, "usage: loglevel [<subsystem>|all none|error|warn|info|debug|trace]\n");
+        return -1;
+    }
+    
+    if (sub == LOG_SUBSYSTEM_COUNT) {
+        for (int i = 0; i < LOG_SUBSYSTEM_COUNT; i++) log_set_level(i, level);
+    } else {
+        log_set_level(sub, level);
+    }
+    if (level > LOG_COMPILE_LEVEL) {
+        sink_printf(io->out, "note: messages above %s are compiled out\n", log_level_name(LOG_COMPILE_LEVEL));
+    }
+    return 1;
+}
+
+/* ACPI PM1a control ports of QEMU (q35/piix4 and older) and Bochs */
+#define ACPI_PM1A_QEMU   0x604
+#define ACPI_PM1A_BOCHS  0xB004
+#define ACPI_SLP_S5      0x2000
+
+/**
+ * builtin_poweroff - Turns the (virtual) machine off
+ * Only emulators are supported; on real hardware the CPU is halted.
+ */
+static int builtin_poweroff(const char *args, const process_io_t *io) {
+    (void)args;
+    sink_printf(io->out, "Powering off\n");
+    serial_flush();
+    
+    outw(ACPI_PM1A_QEMU, ACPI_SLP_S5);
+    outw(ACPI_PM1A_BOCHS, ACPI_SLP_S5);
+    
+    cpu_irq_save();
+    for (;;) {
+        __asm__ volatile ("hlt");
+    }
+    return 1;
+}
+
+/**
+ * builtin_bootinfo - Shows what the loader passed: command line and memory map
+ */
+static int builtin_bootinfo(const char *args, const process_io_t *io) {
+    (void)args;
+    boot_info_print(io->out);
+    return 1;
+}
+
+/**
+ * builtin_boottime - Shows how long each kernel init stage took
+ */
+static int builtin_boottime(const char *args, const process_io_t *io) {
+    (void)args;
+    boot_timeline_print(io->out);
+    return 1;
+}
+
+/* Megabytes moved per ntbench measurement unless given */
+#define NTBENCH_DEFAULT_MB 64
+
+/**
+ * builtin_ntbench - Compares the streaming and rep paths of memcpy/memset
+ * Usage: ntbench [megabytes per measurement]
+ */
+static int builtin_ntbench(const char *args, const process_io_t *io) {
+    char word[16];
+    next_word(args, word, sizeof(word));
+    
+    uint32_t mb = 0;
+    for (const char *p = word; *p >= '0' && *p <= '9'; p++) {
+        mb = mb * 10 + (uint32_t)(*p - '0');
     }
+    if (mb == 0) mb = NTBENCH_DEFAULT_MB;
     
-    argv[argc] = NULL;  // NULL-terminate argv
+    return ntbench_run(io->out, mb) ? 1 : -1;
+}
 
-    // Execute program with arguments
-    int result = process_exec(path, argc, argv);
+/**
+ * execute_stage - Runs one pipeline stage, a builtin or a program, with the given streams
+ */
+static int execute_stage(const char *cmdline, const process_io_t *io) {
+    // One allocation holds argv[] and every string; argv[0] is the command name
+    int argc = 0;
+    char **argv = argv_block_from_cmdline(cmdline, &argc);
+    if (!argv) return 0;
 
-    // Free allocated argument copies
-    for (int j = 1; j < argc; j++) {
-        kfree(argv[j]);
+    const builtin_t *builtin = find_builtin(argv[0]);
+    if (builtin) {
+        kfree(argv);
+        return builtin->handler(skip_command_name(cmdline), io);
     }
+
+    // Resolve to filesystem path
+    char *path = resolve_command_path(argv[0]);
+    if (!path) {
+        kfree(argv);
+        return 0; // not found
+    }
+
+    // The process owns the block from here on
+    int result = process_exec_block(path, argc, argv, io);
     
     kfree(path);
     return result;
 }
 
+/**
+ * split_redirect - Cuts "cmd > file" or "cmd >> file" in place
+ * Returns the file name (possibly empty), or NULL without redirection.
+ */
+static char *split_redirect(char *stage, bool *append) {
+    char *op = strchr(stage, '>');
+    if (!op) return NULL;
+    
+    *append = op[1] == '>';
+    *op = '\0';
+    
+    char *name = op + (*append ? 2 : 1);
+    while (*name == ' ' || *name == '\t') name++;
+    char *end = name;
+    while (*end && *end != ' ' && *end != '\t') end++;
+    *end = '\0';
+    return name;
+}
+
+/**
+ * try_execute_command - Runs a command line
+ *
+ * Stages separated by '|' run one after another, each reading the output
+ * of the previous one from a pipe. The last stage may redirect its output
+ * with '>' (truncate) or '>>' (append); the file is written once, when
+ * the pipeline is done.
+ * Returns the result of the last stage that ran: > 0 on success, 0 if a
+ * command was not found, < 0 on error.
+ */
+int try_execute_command(const char *cmdline) {
+    if (!cmdline) return -1;
+
+    size_t len = strlen(cmdline);
+    char *line = kmalloc(len + 1);
+    if (!line) return -1;
+    memcpy(line, cmdline, len + 1);
+
+    char *stages[MAX_PIPELINE_STAGES];
+    int count = 0;
+    char *p = line;
+    stages[count++] = p;
+    while ((p = strchr(p, '|')) != NULL) {
+        if (count == MAX_PIPELINE_STAGES) {
+            printf("Too many pipeline stages (max %d)\n", MAX_PIPELINE_STAGES);
+            kfree(line);
+            return -1;
+        }
+        *p++ = '\0';
+        stages[count++] = p;
+    }
+
+    // Only the last stage may redirect its output
+    for (int i = 0; i < count - 1; i++) {
+        if (strchr(stages[i], '>')) {
+            printf("Only the last command of a pipeline can redirect output\n");
+            kfree(line);
+            return -1;
+        }
+    }
+
+    bool append = false;
+    char *target = split_redirect(stages[count - 1], &append);
+    sink_t file_sink;
+    sink_t *final_out = process_stdout();
+    char target_path[256];
+    
+    if (target) {
+        if (*target == '\0') {
+            printf("Missing file name after >\n");
+            kfree(line);
+            return -1;
+        }
+        
+        char to_check[256];
+        if (target[0] == '/') {
+            strncpy(to_check, target, sizeof(to_check) - 1);
+            to_check[sizeof(to_check) - 1] = '\0';
+        } else {
+            snprintf(to_check, sizeof(to_check), "/%s", target);
+        }
+        fs_canonicalize(to_check, target_path, sizeof(target_path));
+        
+        if (strcmp(target_path, SERIAL_DEVICE_PATH) == 0) {
+            final_out = sink_serial();
+        } else if (!sink_open_file(&file_sink, target_path, append)) {
+            printf("Cannot open %s for writing\n", target_path);
+            kfree(line);
+            return -1;
+        } else {
+            final_out = &file_sink;
+        }
+    }
+
+    int result = 0;
+    pipe_t *in = NULL;
+    sink_t pipe_sink;
+    
+    for (int i = 0; i < count; i++) {
+        process_io_t io = { final_out, in };
+        pipe_t *out_pipe = NULL;
+        
+        if (i < count - 1) {
+            out_pipe = pipe_create(PIPE_DEFAULT_CAPACITY);
+            if (!out_pipe) {
+                printf("Failed to allocate pipe\n");
+                result = -1;
+                break;
+            }
+            sink_init_pipe(&pipe_sink, out_pipe);
+            io.out = &pipe_sink;
+        }
+        
+        result = execute_stage(stages[i], &io);
+        
+        if (out_pipe) {
+            sink_close(&pipe_sink);
+            pipe_close_write(out_pipe);
+            if (out_pipe->dropped) {
+                printf("Pipe full: %u bytes dropped\n", out_pipe->dropped);
+            }
+        }
+        pipe_destroy(in);
+        in = out_pipe;
+        
+        if (result <= 0) break;
+    }
+    pipe_destroy(in);
+
+    if (final_out == &file_sink && !sink_close(&file_sink)) {
+        printf("Failed to write %s\n", target_path);
+    }
+    
+    kfree(line);
+    return result;
+}
+
 void terminal_console(void){
     uint8_t scancode = keyboard_get_scancode();
     update_hot_key_state(scancode);
@@ -394,6 +676,9 @@ void terminal_console(void){
 
     if (!prompt_shown) print_prompt();
 
+    /* Idle: finish the file system's lazy init a few blocks at a time */
+    if (scancode == 0x00) ipo_fs_lazy_init_step(FS_IDLE_INIT_BLOCKS);
+
     if (scancode != 0x00) {
         update_hot_key_state(scancode);
         hot_key_handler(scancode);
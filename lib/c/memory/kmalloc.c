@@ -18,6 +18,7 @@ typedef struct {
 // Kernel heap state
 static uint8_t *heap_start = NULL;
 static size_t heap_used = 0;
+static kmalloc_stats_t stats;
 
 /**
  * Initialize kernel allocator
@@ -25,6 +26,7 @@ static size_t heap_used = 0;
 void kmalloc_init(void) {
     heap_start = (uint8_t *)KMALLOC_HEAP_START;
     heap_used = 0;
+    memset(&stats, 0, sizeof(stats));
 }
 
 /**
@@ -113,6 +115,12 @@ void* kmalloc(size_t size) {
         block->is_free = 0;
     }
     
+    stats.bytes_in_use += block->size;
+    stats.alloc_count++;
+    if (stats.bytes_in_use > stats.peak_bytes) {
+        stats.peak_bytes = stats.bytes_in_use;
+    }
+    
     // Zero-initialize the allocated memory
     void *user_ptr = (void *)((uint8_t *)block + BLOCK_HEADER_SIZE);
     memset(user_ptr, 0, size);
@@ -143,4 +151,32 @@ void kfree(void* ptr) {
     // Mark as free
     block->is_free = 1;
     block->magic = KMALLOC_FREED_MAGIC;
+    
+    stats.bytes_in_use -= block->size;
+    stats.free_count++;
+}
+
+/**
+ * Get allocator counters (sizes include block headers)
+ */
+void kmalloc_get_stats(kmalloc_stats_t *out) {
+    if (out) *out = stats;
+}
+
+/**
+ * Restart peak tracking from the current usage, returning the old peak
+ */
+size_t kmalloc_reset_peak(void) {
+    size_t old_peak = stats.peak_bytes;
+    stats.peak_bytes = stats.bytes_in_use;
+    return old_peak;
+}
+
+/**
+ * Fold a previously saved peak back in
+ */
+void kmalloc_merge_peak(size_t peak) {
+    if (peak > stats.peak_bytes) {
+        stats.peak_bytes = peak;
+    }
 }
@@ -1,70 +1,153 @@
 #include <stdio.h>
 #include <stdint.h>
 
-/**
- * Convert unsigned 64-bit integer to string
+/* "00" "01" ... "99": two decimal digits per lookup */
+static const char digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static const char digit_chars[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+/* num / 100 for any 32-bit num: (num * ceil(2^37 / 100)) >> 37 */
+static inline uint32_t div100(uint32_t num) {
+    return (uint32_t)(((uint64_t)num * 0x51EB851Fu) >> 37);
+}
+
+/*
+ * Divides *n by a 32-bit divisor and returns the remainder using two
+ * 32-bit divides (the second one a single divl of edx:eax), instead of
+ * libgcc's 64-bit division.
  */
-int itoa64(uint64_t num, char *str, int base) {
-    int len = 0;
-    uint64_t digits[64];
-    int i = 0;
+static inline uint32_t div64_32(uint64_t *n, uint32_t divisor) {
+    uint32_t hi = (uint32_t)(*n >> 32);
+    uint32_t lo = (uint32_t)*n;
+    uint32_t q_hi = hi / divisor;
+    uint32_t q_lo, rem;
     
-    if (num == 0) {
-        str[0] = '0';
-        str[1] = '\0';
-        return 1;
-    }
+    hi %= divisor;  // < divisor, so the quotient below fits in 32 bits
+    __asm__ ("divl %4" : "=a"(q_lo), "=d"(rem) : "a"(lo), "d"(hi), "rm"(divisor));
     
-    while (num > 0 && i < 63) {
-        digits[i++] = num % base;
-        num /= base;
+    *n = ((uint64_t)q_hi << 32) | q_lo;
+    return rem;
+}
+
+static inline int decimal_length(uint32_t num) {
+    if (num < 10) return 1;
+    if (num < 100) return 2;
+    if (num < 1000) return 3;
+    if (num < 10000) return 4;
+    if (num < 100000) return 5;
+    if (num < 1000000) return 6;
+    if (num < 10000000) return 7;
+    if (num < 100000000) return 8;
+    if (num < 1000000000) return 9;
+    return 10;
+}
+
+/* Writes exactly len decimal digits of num ending at end[-1], two at a time */
+static void put_decimal(char *end, uint32_t num, int len) {
+    while (len >= 2) {
+        uint32_t q = div100(num);
+        uint32_t r = num - q * 100;
+        end -= 2;
+        end[0] = digit_pairs[r * 2];
+        end[1] = digit_pairs[r * 2 + 1];
+        num = q;
+        len -= 2;
     }
+    if (len) *--end = (char)('0' + num);
+}
+
+/* Power-of-two bases: shift/mask per digit */
+static int put_pow2(uint64_t num, char *str, int shift) {
+    uint32_t mask = (1u << shift) - 1;
+    int len = 0;
+    for (uint64_t t = num; t; t >>= shift) len++;
+    if (len == 0) len = 1;
     
-    for (int j = i - 1; j >= 0; j--) {
-        uint64_t digit = digits[j];
-        if (len >= 63) break;  // Leave space for null terminator
-        if (digit < 10) {
-            str[len++] = '0' + digit;
-        } else {
-            str[len++] = 'a' + (digit - 10);
-        }
+    for (int i = len - 1; i >= 0; i--) {
+        str[i] = digit_chars[(uint32_t)num & mask];
+        num >>= shift;
     }
+    str[len] = '\0';
+    return len;
+}
+
+/* Any other base, one division per digit */
+static int put_generic(uint64_t num, char *str, int base) {
+    char tmp[64];
+    int len = 0;
+    do {
+        tmp[len++] = digit_chars[div64_32(&num, (uint32_t)base)];
+    } while (num && len < 63);
     
-    // Always null-terminate for safety
+    for (int i = 0; i < len; i++) str[i] = tmp[len - 1 - i];
     str[len] = '\0';
     return len;
 }
 
+static int shift_for_base(int base) {
+    switch (base) {
+    case 2:  return 1;
+    case 8:  return 3;
+    case 16: return 4;
+    default: return 0;
+    }
+}
+
 /**
- * Convert unsigned integer to string
+ * Convert unsigned 64-bit integer to string
  */
-int itoa(unsigned int num, char *str, int base) {
-    int len = 0;
-    unsigned int digits[32];
-    int i = 0;
+int itoa64(uint64_t num, char *str, int base) {
+    if (base != 10) {
+        int shift = shift_for_base(base);
+        return shift ? put_pow2(num, str, shift) : put_generic(num, str, base);
+    }
     
-    if (num == 0) {
-        str[0] = '0';
-        return 1;
+    if ((num >> 32) == 0) {
+        return itoa((uint32_t)num, str, 10);
     }
     
-    while (num > 0 && i < 32) {
-        digits[i++] = num % base;
-        num /= base;
+    // Split into 9-digit groups, each small enough for the 32-bit path
+    uint32_t low = div64_32(&num, 1000000000u);
+    uint32_t mid = 0;
+    int groups = 1;
+    if (num >> 32 || num >= 1000000000u) {
+        mid = div64_32(&num, 1000000000u);
+        groups = 2;
     }
+    uint32_t top = (uint32_t)num;
     
-    // i now contains the number of digits (max 32 for 32-bit unsigned)
-    for (int j = i - 1; j >= 0; j--) {
-        unsigned int digit = digits[j];
-        if (len >= 31) break;  // Leave space for null terminator
-        if (digit < 10) {
-            str[len++] = '0' + digit;
-        } else {
-            str[len++] = 'a' + (digit - 10);
-        }
+    int len = itoa(top, str, 10);
+    if (groups == 2) {
+        put_decimal(str + len + 9, mid, 9);
+        len += 9;
+    }
+    put_decimal(str + len + 9, low, 9);
+    len += 9;
+    str[len] = '\0';
+    return len;
+}
+
+/**
+ * Convert unsigned integer to string
+ */
+int itoa(unsigned int num, char *str, int base) {
+    if (base != 10) {
+        int shift = shift_for_base(base);
+        return shift ? put_pow2(num, str, shift) : put_generic(num, str, base);
     }
     
-    // Always null-terminate for safety
+    int len = decimal_length(num);
+    put_decimal(str + len, num, len);
     str[len] = '\0';
     return len;
-}
\ No newline at end of file
+}
@@ -1,132 +1,25 @@
 #include <stdio.h>
 #include <stdint.h>
 
+static void console_sink_write(format_sink_t *sink, const char *buf, size_t len) {
+    console_write(buf, len);
+}
+
+/**
+ * Formatted print function, va_list version
+ */
+int vprintf(const char *format, va_list args) {
+    format_sink_t sink = { console_sink_write, NULL };
+    return vformat(&sink, format, args);
+}
+
 /**
  * Formatted print function
  */
 int printf(const char *format, ...) {
     va_list args;
     va_start(args, format);
-    
-    int count = 0;
-    
-    while (*format) {
-        if (*format == '%' && *(format + 1)) {
-            format++;
-            
-            /* Check for 'l' length modifier */
-            int is_long = 0;
-            if (*format == 'l' && *(format + 1) == 'l') {
-                is_long = 1;
-                format += 2;
-            } else if (*format == 'l') {
-                is_long = 1;
-                format++;
-            }
-            
-            if (!*format) break;
-            
-            switch (*format) {
-                case 'd': {
-                    /* Signed integer */
-                    int val = va_arg(args, int);
-                    char buf[32];
-                    int len = 0;
-                    
-                    if (val < 0) {
-                        putchar('-');
-                        count++;
-                        // Convert to absolute value safely
-                        // For INT_MIN, we use (unsigned int)(-(long)val) to avoid overflow
-                        unsigned int abs_val = (unsigned int)(-(long)val);
-                        len = itoa(abs_val, buf, 10);
-                    } else {
-                        len = itoa((unsigned int)val, buf, 10);
-                    }
-                    
-                    for (int i = 0; i < len && i < 32; i++) {
-                        putchar(buf[i]);
-                        count++;
-                    }
-                    break;
-                }
-                
-                case 'u': {
-                    if (is_long) {
-                        /* Unsigned long long */
-                        uint64_t val = va_arg(args, uint64_t);
-                        char buf[64];
-                        int len = itoa64(val, buf, 10);
-                        for (int i = 0; i < len; i++) {
-                            putchar(buf[i]);
-                            count++;
-                        }
-                    } else {
-                        /* Unsigned integer */
-                        unsigned int val = va_arg(args, unsigned int);
-                        char buf[32];
-                        int len = itoa(val, buf, 10);
-                        for (int i = 0; i < len; i++) {
-                            putchar(buf[i]);
-                            count++;
-                        }
-                    }
-                    break;
-                }
-                
-                case 'x': {
-                    /* Hexadecimal */
-                    unsigned int val = va_arg(args, unsigned int);
-                    char buf[32];
-                    int len = itoa(val, buf, 16);
-                    for (int i = 0; i < len; i++) {
-                        putchar(buf[i]);
-                        count++;
-                    }
-                    break;
-                }
-                
-                case 'c': {
-                    /* Character */
-                    char val = (char)va_arg(args, int);
-                    putchar(val);
-                    count++;
-                    break;
-                }
-                
-                case 's': {
-                    /* String */
-                    const char *str = va_arg(args, const char*);
-                    if (str) {
-                        while (*str) {
-                            putchar(*str++);
-                            count++;
-                        }
-                    }
-                    break;
-                }
-                
-                case '%': {
-                    /* Literal % */
-                    putchar('%');
-                    count++;
-                    break;
-                }
-                
-                default:
-                    putchar('%');
-                    putchar(*format);
-                    count += 2;
-                    break;
-            }
-        } else {
-            putchar(*format);
-            count++;
-        }
-        
-        format++;
-    }
-    
+    int count = vprintf(format, args);
     va_end(args);
     return count;
-}
\ No newline at end of file
+}
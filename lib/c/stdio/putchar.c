@@ -11,6 +11,19 @@ void putchar(char c) {
 }
 
 void putchar_color(char c, uint8_t fg, uint8_t bg) {
+    console_write_color(&c, 1, fg, bg);
+}
+
+void console_write(const char *buf, size_t len) {
+    console_write_color(buf, len, VGA_COLOR_LIGHT_GREY, VGA_COLOR_BLACK);
+}
+
+/**
+ * Write a run of characters, reading and updating the hardware cursor once
+ */
+void console_write_color(const char *buf, size_t len, uint8_t fg, uint8_t bg) {
+    if (len == 0) return;
+    
     volatile uint16_t *vga = VGA_MEMORY;
     uint16_t cursor = vga_get_cursor_position();
     uint16_t top_row = VGA_START_CURSOR_POSITION / VGA_WIDTH;
@@ -22,37 +35,43 @@ void putchar_color(char c, uint8_t fg, uint8_t bg) {
         cursor = VGA_START_CURSOR_POSITION;
     }
     
-    if (c == '\n') {
-        /* Move to next line */
-        uint16_t row = cursor / VGA_WIDTH;
-        cursor = (row + 1) * VGA_WIDTH;
-    } else if (c == '\r') {
-        /* Move to start of line */
-        uint16_t row = cursor / VGA_WIDTH;
-        cursor = row * VGA_WIDTH;
-    } else if (c == '\t') {
-        /* Move to next tab stop (8 chars) */
-        uint16_t col = cursor % VGA_WIDTH;
-        uint16_t spaces = 8 - (col % 8);
-        // Don't exceed terminal bounds
-        if (cursor + spaces >= terminal_bottom) {
-            cursor = terminal_bottom - VGA_WIDTH;
+    for (size_t i = 0; i < len; i++) {
+        char c = buf[i];
+        
+        if (c == '\n') {
+            /* Move to next line */
+            uint16_t row = cursor / VGA_WIDTH;
+            cursor = (row + 1) * VGA_WIDTH;
+        } else if (c == '\r') {
+            /* Move to start of line */
+            uint16_t row = cursor / VGA_WIDTH;
+            cursor = row * VGA_WIDTH;
+        } else if (c == '\t') {
+            /* Move to next tab stop (8 chars) */
+            uint16_t col = cursor % VGA_WIDTH;
+            uint16_t spaces = 8 - (col % 8);
+            // Don't exceed terminal bounds
+            if (cursor + spaces >= terminal_bottom) {
+                cursor = terminal_bottom - VGA_WIDTH;
+            } else {
+                cursor += spaces;
+            }
         } else {
-            cursor += spaces;
+            /* Print character at current position */
+            vga[cursor] = vga_entry((unsigned char)c, fg, bg);
+            cursor++;
+        }
+        
+        /* Handle overflow by scrolling */
+        if (cursor >= terminal_bottom) {
+            /* Call auto-scroll to save history and shift lines up */
+            terminal_auto_scroll();
+            /* Hardware scrolling moves the visible window */
+            vga = VGA_MEMORY;
+            /* Cursor is now at the start of the last line */
+            cursor = terminal_bottom - VGA_WIDTH;
         }
-    } else {
-        /* Print character at current position */
-        vga[cursor] = vga_entry((unsigned char)c, fg, bg);
-        cursor++;
-    }
-    
-    /* Handle overflow by scrolling */
-    if (cursor >= terminal_bottom) {
-        /* Call auto-scroll to save history and shift lines up */
-        terminal_auto_scroll();
-        /* Cursor is now at the start of the last line */
-        cursor = terminal_bottom - VGA_WIDTH;
     }
     
     vga_set_cursor(cursor);
-}
\ No newline at end of file
+}
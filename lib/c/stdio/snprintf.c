@@ -1,103 +1,42 @@
 #include <stdio.h>
 #include <stdint.h>
 
+typedef struct {
+    format_sink_t sink;
+    char *buf;
+    size_t written;
+    size_t max_write;   // Room left for characters, excluding the terminator
+} buffer_sink_t;
+
+static void buffer_sink_write(format_sink_t *sink, const char *data, size_t len) {
+    buffer_sink_t *b = (buffer_sink_t *)sink;
+    size_t room = b->max_write - b->written;
+    if (len > room) len = room;
+    for (size_t i = 0; i < len; i++) {
+        b->buf[b->written++] = data[i];
+    }
+}
+
 /**
- * Formatted print to buffer
+ * Formatted print to buffer, va_list version
  */
-int snprintf(char *buf, size_t size, const char *format, ...) {
+int vsnprintf(char *buf, size_t size, const char *format, va_list args) {
     if (size == 0) return 0;
     if (!buf) return 0;
     
+    buffer_sink_t b = { { buffer_sink_write, NULL }, buf, 0, size - 1 };  // Reserve space for null terminator
+    vformat(&b.sink, format, args);
+    buf[b.written] = '\0';
+    return (int)b.written;
+}
+
+/**
+ * Formatted print to buffer
+ */
+int snprintf(char *buf, size_t size, const char *format, ...) {
     va_list args;
     va_start(args, format);
-    
-    size_t written = 0;
-    size_t max_write = size - 1;  // Reserve space for null terminator
-    
-    while (*format && written < max_write) {
-        if (*format == '%' && *(format + 1)) {
-            format++;
-            
-            /* Check for 'l' length modifier */
-            int is_long = 0;
-            if (*format == 'l' && *(format + 1) == 'l') {
-                is_long = 1;
-                format += 2;
-            } else if (*format == 'l') {
-                is_long = 1;
-                format++;
-            }
-            
-            if (!*format) break;
-            
-            switch (*format) {
-                case 'd':
-                case 'i': {
-                    long long value = is_long ? va_arg(args, long long) : (long long)va_arg(args, int);
-                    char temp_buf[32];
-                    int n = itoa(value, temp_buf, 10);
-                    if (n > 0) {
-                        int to_copy = (n > (int)(max_write - written)) ? (max_write - written) : n;
-                        for (int i = 0; i < to_copy; i++) {
-                            buf[written++] = temp_buf[i];
-                        }
-                    }
-                    break;
-                }
-                
-                case 's': {
-                    const char *s = va_arg(args, const char *);
-                    if (!s) s = "(null)";
-                    while (*s && written < max_write) {
-                        buf[written++] = *s++;
-                    }
-                    break;
-                }
-                
-                case 'x': {
-                    unsigned long value = is_long ? va_arg(args, unsigned long) : (unsigned long)va_arg(args, unsigned int);
-                    char temp_buf[32];
-                    int n = itoa(value, temp_buf, 16);
-                    if (n > 0) {
-                        int to_copy = (n > (int)(max_write - written)) ? (max_write - written) : n;
-                        for (int i = 0; i < to_copy; i++) {
-                            buf[written++] = temp_buf[i];
-                        }
-                    }
-                    break;
-                }
-                
-                case 'c': {
-                    int c = va_arg(args, int);
-                    if (written < max_write) {
-                        buf[written++] = (char)c;
-                    }
-                    break;
-                }
-                
-                case '%': {
-                    if (written < max_write) {
-                        buf[written++] = '%';
-                    }
-                    break;
-                }
-                
-                default:
-                    if (written < max_write) buf[written++] = '%';
-                    if (written < max_write) buf[written++] = *format;
-                    break;
-            }
-        } else {
-            if (written < max_write) {
-                buf[written++] = *format;
-            }
-        }
-        
-        format++;
-    }
-    
-    buf[written] = '\0';
-    
+    int written = vsnprintf(buf, size, format, args);
     va_end(args);
-    return (int)written;
+    return written;
 }
@@ -0,0 +1,233 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Output is staged on the stack and handed to the sink in chunks */
+#define VFORMAT_CHUNK 128
+
+typedef struct {
+    format_sink_t *sink;
+    char buf[VFORMAT_CHUNK];
+    size_t len;
+    int count;
+} format_out_t;
+
+/* Conversion flags */
+#define FMT_LEFT   0x01  // '-'
+#define FMT_ZERO   0x02  // '0'
+#define FMT_PLUS   0x04  // '+'
+#define FMT_SPACE  0x08  // ' '
+#define FMT_ALT    0x10  // '#'
+
+static void out_flush(format_out_t *out) {
+    if (out->len) {
+        out->sink->write(out->sink, out->buf, out->len);
+        out->len = 0;
+    }
+}
+
+static void out_char(format_out_t *out, char c) {
+    out->buf[out->len++] = c;
+    out->count++;
+    if (out->len == VFORMAT_CHUNK) {
+        out_flush(out);
+    }
+}
+
+static void out_repeat(format_out_t *out, char c, int n) {
+    while (n-- > 0) out_char(out, c);
+}
+
+static void out_str(format_out_t *out, const char *s, int n) {
+    for (int i = 0; i < n; i++) out_char(out, s[i]);
+}
+
+/**
+ * format_number - Emits digits with sign/prefix, precision and field padding
+ */
+static void format_number(format_out_t *out, uint64_t value, bool negative, int base,
+                          bool upper, int flags, int width, int precision) {
+    char digits[32];
+    int ndigits;
+    
+    if (precision == 0 && value == 0) {
+        ndigits = 0;  // "%.0d" of zero prints nothing
+    } else if (value >> 32) {
+        ndigits = itoa64(value, digits, base);
+    } else {
+        ndigits = itoa((unsigned int)value, digits, base);
+    }
+    
+    if (upper) {
+        for (int i = 0; i < ndigits; i++) {
+            if (digits[i] >= 'a' && digits[i] <= 'f') digits[i] -= 'a' - 'A';
+        }
+    }
+    
+    char prefix[3];
+    int nprefix = 0;
+    if (negative) prefix[nprefix++] = '-';
+    else if (flags & FMT_PLUS) prefix[nprefix++] = '+';
+    else if (flags & FMT_SPACE) prefix[nprefix++] = ' ';
+    if ((flags & FMT_ALT) && base == 16 && value != 0) {
+        prefix[nprefix++] = '0';
+        prefix[nprefix++] = upper ? 'X' : 'x';
+    }
+    
+    int zeros = precision > ndigits ? precision - ndigits : 0;
+    // '#' with octal raises the precision just enough to lead with a 0
+    if ((flags & FMT_ALT) && base == 8 && zeros == 0 && (ndigits == 0 || digits[0] != '0')) {
+        zeros = 1;
+    }
+    int pad = width - nprefix - zeros - ndigits;
+    
+    // The '0' flag is ignored with a precision or left alignment
+    if ((flags & FMT_ZERO) && !(flags & FMT_LEFT) && precision < 0 && pad > 0) {
+        zeros += pad;
+        pad = 0;
+    }
+    
+    if (!(flags & FMT_LEFT)) out_repeat(out, ' ', pad);
+    out_str(out, prefix, nprefix);
+    out_repeat(out, '0', zeros);
+    out_str(out, digits, ndigits);
+    if (flags & FMT_LEFT) out_repeat(out, ' ', pad);
+}
+
+static void format_string(format_out_t *out, const char *s, int flags, int width, int precision) {
+    int len = 0;
+    while (s[len] && (precision < 0 || len < precision)) len++;
+    
+    int pad = width - len;
+    if (!(flags & FMT_LEFT)) out_repeat(out, ' ', pad);
+    out_str(out, s, len);
+    if (flags & FMT_LEFT) out_repeat(out, ' ', pad);
+}
+
+int vformat(format_sink_t *sink, const char *format, va_list args) {
+    format_out_t out;
+    out.sink = sink;
+    out.len = 0;
+    out.count = 0;
+    
+    while (*format) {
+        if (*format != '%') {
+            out_char(&out, *format++);
+            continue;
+        }
+        format++;
+        
+        /* Flags */
+        int flags = 0;
+        for (;;) {
+            if (*format == '-') flags |= FMT_LEFT;
+            else if (*format == '0') flags |= FMT_ZERO;
+            else if (*format == '+') flags |= FMT_PLUS;
+            else if (*format == ' ') flags |= FMT_SPACE;
+            else if (*format == '#') flags |= FMT_ALT;
+            else break;
+            format++;
+        }
+        
+        /* Width */
+        int width = 0;
+        if (*format == '*') {
+            width = va_arg(args, int);
+            if (width < 0) {
+                flags |= FMT_LEFT;
+                width = -width;
+            }
+            format++;
+        } else {
+            while (*format >= '0' && *format <= '9') {
+                width = width * 10 + (*format++ - '0');
+            }
+        }
+        
+        /* Precision */
+        int precision = -1;
+        if (*format == '.') {
+            format++;
+            precision = 0;
+            if (*format == '*') {
+                precision = va_arg(args, int);
+                if (precision < 0) precision = -1;
+                format++;
+            } else {
+                while (*format >= '0' && *format <= '9') {
+                    precision = precision * 10 + (*format++ - '0');
+                }
+            }
+        }
+        
+        /* Length: only ll changes the argument size on i386 */
+        int is_64 = 0;
+        if (*format == 'l' && format[1] == 'l') {
+            is_64 = 1;
+            format += 2;
+        } else if (*format == 'l' || *format == 'z') {
+            format++;
+        } else if (*format == 'h') {
+            format++;
+            if (*format == 'h') format++;
+        }
+        
+        if (!*format) break;
+        
+        char conv = *format++;
+        switch (conv) {
+            case 'd':
+            case 'i': {
+                int64_t v = is_64 ? va_arg(args, int64_t) : (int64_t)va_arg(args, int);
+                uint64_t mag = v < 0 ? (uint64_t)0 - (uint64_t)v : (uint64_t)v;
+                format_number(&out, mag, v < 0, 10, false, flags, width, precision);
+                break;
+            }
+            
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o': {
+                uint64_t v = is_64 ? va_arg(args, uint64_t) : (uint64_t)va_arg(args, unsigned int);
+                int base = conv == 'u' ? 10 : (conv == 'o' ? 8 : 16);
+                format_number(&out, v, false, base, conv == 'X', flags & ~(FMT_PLUS | FMT_SPACE),
+                              width, precision);
+                break;
+            }
+            
+            case 'p': {
+                uintptr_t v = (uintptr_t)va_arg(args, void *);
+                out_str(&out, "0x", 2);
+                format_number(&out, v, false, 16, false, FMT_ZERO, 8, -1);
+                break;
+            }
+            
+            case 'c': {
+                char c = (char)va_arg(args, int);
+                if (!(flags & FMT_LEFT)) out_repeat(&out, ' ', width - 1);
+                out_char(&out, c);
+                if (flags & FMT_LEFT) out_repeat(&out, ' ', width - 1);
+                break;
+            }
+            
+            case 's': {
+                const char *s = va_arg(args, const char *);
+                format_string(&out, s ? s : "(null)", flags, width, precision);
+                break;
+            }
+            
+            case '%':
+                out_char(&out, '%');
+                break;
+            
+            default:
+                /* Unknown conversion: print it as written */
+                out_char(&out, '%');
+                out_char(&out, conv);
+                break;
+        }
+    }
+    
+    out_flush(&out);
+    return out.count;
+}
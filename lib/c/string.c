@@ -1,4 +1,6 @@
 #include <string.h>
+#include <stdint.h>
+#include <system/sse.h>
 
 char* strcpy(char *dest, const char *src) {
     char *d = dest;
@@ -40,34 +42,197 @@ char *strchr(const char *s, int c) {
     return NULL;
 }
 
+/* Word access that may alias any object, for the word-at-a-time loops */
+typedef uint32_t __attribute__((may_alias)) word_t;
+
+#define ONES  0x01010101u
+#define HIGHS 0x80808080u
+
+/* Below this size the rep setup costs more than it saves */
+#define STRING_REP_MIN 16
+
+/* From this size on a copy would only evict the cache: stream it past */
+#define STRING_NT_MIN (64 * 1024)
+
+/*
+ * Set through string_use_sse() by the kernel. Starts at -1 rather than 0
+ * so it lands in .data: applications link their own copy of this file
+ * and only ship .data, where it stays -1 and keeps them scalar. Kept
+ * here rather than in sse.c so that strlen alone does not pull the
+ * kernel into an application.
+ */
+static int use_sse = -1;
+
+void string_use_sse(bool enabled) {
+    use_sse = enabled ? 1 : 0;
+}
+
+/*
+ * Streams blocks * 64 bytes with SSE2 non-temporal stores; dst must be
+ * 16-byte aligned. xmm0-3 are preserved, so this is safe inside system
+ * calls made by code that keeps live SSE state.
+ */
+static void copy_nt(void *dst, const void *src, size_t blocks) {
+    uint8_t saved[64];
+    __asm__ volatile (
+        "movdqu %%xmm0, 0(%3)\n\t"
+        "movdqu %%xmm1, 16(%3)\n\t"
+        "movdqu %%xmm2, 32(%3)\n\t"
+        "movdqu %%xmm3, 48(%3)\n"
+        "1:\n\t"
+        "prefetchnta 256(%1)\n\t"
+        "movdqu 0(%1), %%xmm0\n\t"
+        "movdqu 16(%1), %%xmm1\n\t"
+        "movdqu 32(%1), %%xmm2\n\t"
+        "movdqu 48(%1), %%xmm3\n\t"
+        "movntdq %%xmm0, 0(%0)\n\t"
+        "movntdq %%xmm1, 16(%0)\n\t"
+        "movntdq %%xmm2, 32(%0)\n\t"
+        "movntdq %%xmm3, 48(%0)\n\t"
+        "add $64, %1\n\t"
+        "add $64, %0\n\t"
+        "dec %2\n\t"
+        "jnz 1b\n\t"
+        "sfence\n\t"
+        "movdqu 0(%3), %%xmm0\n\t"
+        "movdqu 16(%3), %%xmm1\n\t"
+        "movdqu 32(%3), %%xmm2\n\t"
+        "movdqu 48(%3), %%xmm3"
+        : "+r"(dst), "+r"(src), "+r"(blocks)
+        : "r"(saved)
+        : "memory");
+}
+
+/* Fills blocks * 64 bytes with the 32-bit pattern; dst 16-byte aligned */
+static void fill_nt(void *dst, uint32_t pattern, size_t blocks) {
+    uint8_t saved[16];
+    __asm__ volatile (
+        "movdqu %%xmm0, (%3)\n\t"
+        "movd %2, %%xmm0\n\t"
+        "pshufd $0, %%xmm0, %%xmm0\n"
+        "1:\n\t"
+        "movntdq %%xmm0, 0(%0)\n\t"
+        "movntdq %%xmm0, 16(%0)\n\t"
+        "movntdq %%xmm0, 32(%0)\n\t"
+        "movntdq %%xmm0, 48(%0)\n\t"
+        "add $64, %0\n\t"
+        "dec %1\n\t"
+        "jnz 1b\n\t"
+        "sfence\n\t"
+        "movdqu (%3), %%xmm0"
+        : "+r"(dst), "+r"(blocks)
+        : "r"(pattern), "r"(saved)
+        : "memory");
+}
+
 void* memset(void *s, int c, size_t n) {
-    unsigned char *p = (unsigned char *)s;
-    for (size_t i = 0; i < n; i++) {
-        p[i] = (unsigned char)c;
+    void *d = s;
+    uint32_t byte = (uint8_t)c;
+    
+    if (n >= STRING_NT_MIN && use_sse > 0) {
+        size_t head = (-(uintptr_t)d) & 15;
+        n -= head;
+        __asm__ volatile ("rep stosb" : "+D"(d), "+c"(head) : "a"(byte) : "memory");
+        
+        size_t blocks = n >> 6;
+        n &= 63;
+        fill_nt(d, byte * ONES, blocks);
+        d = (uint8_t *)d + (blocks << 6);
+    }
+    
+    if (n >= STRING_REP_MIN) {
+        // Align the destination so every stosd is a single aligned store
+        size_t head = (-(uintptr_t)d) & 3;
+        n -= head;
+        __asm__ volatile ("rep stosb" : "+D"(d), "+c"(head) : "a"(byte) : "memory");
+        
+        size_t words = n >> 2;
+        n &= 3;
+        __asm__ volatile ("rep stosl" : "+D"(d), "+c"(words) : "a"(byte * ONES) : "memory");
     }
+    __asm__ volatile ("rep stosb" : "+D"(d), "+c"(n) : "a"(byte) : "memory");
     return s;
 }
 
 void* memcpy(void *dest, const void *src, size_t n) {
-    unsigned char *d = (unsigned char *)dest;
-    const unsigned char *s = (const unsigned char *)src;
-    for (size_t i = 0; i < n; i++) {
-        d[i] = s[i];
+    void *d = dest;
+    
+    if (n >= STRING_NT_MIN && use_sse > 0) {
+        size_t head = (-(uintptr_t)d) & 15;
+        n -= head;
+        __asm__ volatile ("rep movsb" : "+D"(d), "+S"(src), "+c"(head) : : "memory");
+        
+        size_t blocks = n >> 6;
+        n &= 63;
+        copy_nt(d, src, blocks);
+        d = (uint8_t *)d + (blocks << 6);
+        src = (const uint8_t *)src + (blocks << 6);
+    }
+    
+    if (n >= STRING_REP_MIN) {
+        size_t head = (-(uintptr_t)d) & 3;
+        n -= head;
+        __asm__ volatile ("rep movsb" : "+D"(d), "+S"(src), "+c"(head) : : "memory");
+        
+        size_t words = n >> 2;
+        n &= 3;
+        __asm__ volatile ("rep movsl" : "+D"(d), "+S"(src), "+c"(words) : : "memory");
+    }
+    __asm__ volatile ("rep movsb" : "+D"(d), "+S"(src), "+c"(n) : : "memory");
+    return dest;
+}
+
+void* memmove(void *dest, const void *src, size_t n) {
+    uint8_t *d = (uint8_t *)dest;
+    const uint8_t *s = (const uint8_t *)src;
+    
+    // A forward copy is safe unless dest starts inside src
+    if (d <= s || d >= s + n) return memcpy(dest, src, n);
+    
+    // Copy downwards: the odd tail bytes first, then whole words
+    size_t tail = n & 3;
+    d += n;
+    s += n;
+    while (tail--) *--d = *--s;
+    
+    size_t words = n >> 2;
+    if (words) {
+        void *dw = d - 4;
+        const void *sw = s - 4;
+        __asm__ volatile ("std\n\trep movsl\n\tcld"
+                          : "+D"(dw), "+S"(sw), "+c"(words) : : "memory");
     }
     return dest;
 }
 
 size_t strlen(const char *s) {
-    size_t len = 0;
-    while (s[len]) {
-        len++;
+    const char *p = s;
+    
+    // Bytes up to the first word boundary; an aligned word never crosses a page
+    while ((uintptr_t)p & 3) {
+        if (!*p) return (size_t)(p - s);
+        p++;
     }
-    return len;
+    
+    const word_t *w = (const word_t *)p;
+    while (!((*w - ONES) & ~*w & HIGHS)) w++;
+    
+    p = (const char *)w;
+    while (*p) p++;
+    return (size_t)(p - s);
 }
 
 int memcmp(const void *a, const void *b, size_t n) {
     const unsigned char *pa = (const unsigned char *)a;
     const unsigned char *pb = (const unsigned char *)b;
+    
+    // Skip equal words; the first differing one is resolved bytewise
+    while (n >= 4 && *(const word_t *)pa == *(const word_t *)pb) {
+        pa += 4;
+        pb += 4;
+        n -= 4;
+    }
+    
     for (size_t i = 0; i < n; i++) {
         if (pa[i] != pb[i]) return (int)pa[i] - (int)pb[i];
     }
@@ -0,0 +1,9 @@
+#include <system/cpu.h>
+
+int cpu_has_feature_edx(uint32_t mask) {
+    uint32_t regs[4];
+    cpu_cpuid(0, regs);
+    if (regs[0] < 1) return 0;
+    cpu_cpuid(1, regs);
+    return (regs[3] & mask) == mask;
+}
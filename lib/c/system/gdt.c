@@ -0,0 +1,74 @@
+#include <system/gdt.h>
+#include <string.h>
+
+#define GDT_ENTRIES 6
+
+struct gdt_entry {
+    uint16_t limit_low;
+    uint16_t base_low;
+    uint8_t  base_middle;
+    uint8_t  access;
+    uint8_t  granularity;
+    uint8_t  base_high;
+} __attribute__((packed));
+
+struct gdt_ptr {
+    uint16_t limit;
+    uint32_t base;
+} __attribute__((packed));
+
+/* 32-bit Task State Segment. Only ss0/esp0 are used (no hardware task switching). */
+struct tss_entry {
+    uint32_t prev_tss;
+    uint32_t esp0;
+    uint32_t ss0;
+    uint32_t esp1, ss1, esp2, ss2;
+    uint32_t cr3, eip, eflags;
+    uint32_t eax, ecx, edx, ebx, esp, ebp, esi, edi;
+    uint32_t es, cs, ss, ds, fs, gs;
+    uint32_t ldt;
+    uint16_t trap;
+    uint16_t iomap_base;
+} __attribute__((packed));
+
+static struct gdt_entry gdt[GDT_ENTRIES];
+static struct gdt_ptr gdt_descriptor;
+static struct tss_entry tss;
+
+static void gdt_set_entry(int index, uint32_t base, uint32_t limit, uint8_t access, uint8_t granularity) {
+    gdt[index].base_low    = base & 0xFFFF;
+    gdt[index].base_middle = (base >> 16) & 0xFF;
+    gdt[index].base_high   = (base >> 24) & 0xFF;
+    gdt[index].limit_low   = limit & 0xFFFF;
+    gdt[index].granularity = ((limit >> 16) & 0x0F) | (granularity & 0xF0);
+    gdt[index].access      = access;
+}
+
+void gdt_init(void) {
+    gdt_set_entry(0, 0, 0, 0, 0);                   /* null */
+    gdt_set_entry(1, 0, 0xFFFFFFFF, 0x9A, 0xCF);    /* kernel code, ring 0 */
+    gdt_set_entry(2, 0, 0xFFFFFFFF, 0x92, 0xCF);    /* kernel data, ring 0 */
+    gdt_set_entry(3, 0, 0xFFFFFFFF, 0xFA, 0xCF);    /* user code, ring 3 */
+    gdt_set_entry(4, 0, 0xFFFFFFFF, 0xF2, 0xCF);    /* user data, ring 3 */
+
+    /* No I/O permission bitmap: port I/O from ring 3 always faults */
+    memset(&tss, 0, sizeof(tss));
+    tss.ss0 = GDT_KERNEL_DATA;
+    tss.esp0 = 0x90000;
+    tss.iomap_base = sizeof(tss);
+    gdt_set_entry(5, (uint32_t)&tss, sizeof(tss) - 1, 0x89, 0x00);
+
+    gdt_descriptor.limit = sizeof(gdt) - 1;
+    gdt_descriptor.base = (uint32_t)&gdt;
+
+    gdt_flush(&gdt_descriptor);
+    tss_flush(GDT_TSS);
+}
+
+void tss_set_kernel_stack(uint32_t esp0) {
+    tss.esp0 = esp0;
+}
+
+uint32_t tss_get_kernel_stack(void) {
+    return tss.esp0;
+}
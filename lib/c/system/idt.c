@@ -0,0 +1,107 @@
+#include <system/idt.h>
+#include <system/gdt.h>
+#include <system/pic.h>
+#include <driver/serial.h>
+#include <kernel/process.h>
+#include <stdio.h>
+#include <string.h>
+
+struct idt_entry {
+    uint16_t base_low;
+    uint16_t selector;
+    uint8_t  zero;
+    uint8_t  flags;
+    uint16_t base_high;
+} __attribute__((packed));
+
+struct idt_ptr {
+    uint16_t limit;
+    uint32_t base;
+} __attribute__((packed));
+
+static struct idt_entry idt[IDT_ENTRIES];
+static struct idt_ptr idt_descriptor;
+static interrupt_handler_t handlers[IDT_ENTRIES];
+
+/* Exception and IRQ entry stubs, defined in lib/asm/interrupt.asm */
+extern uint32_t isr_stub_table[32];
+extern uint32_t irq_stub_table[PIC_IRQ_COUNT];
+
+static const char *exception_names[32] = {
+    "Divide error", "Debug", "NMI", "Breakpoint",
+    "Overflow", "Bound range", "Invalid opcode", "Device not available",
+    "Double fault", "Coprocessor overrun", "Invalid TSS", "Segment not present",
+    "Stack fault", "General protection", "Page fault", "Reserved",
+    "x87 FPU error", "Alignment check", "Machine check", "SIMD FP exception",
+    "Virtualization", "Control protection", "Reserved", "Reserved",
+    "Reserved", "Reserved", "Reserved", "Reserved",
+    "Reserved", "Reserved", "Security", "Reserved"
+};
+
+void idt_set_gate(uint8_t vector, uint32_t handler, uint8_t flags) {
+    idt[vector].base_low = handler & 0xFFFF;
+    idt[vector].base_high = (handler >> 16) & 0xFFFF;
+    idt[vector].selector = GDT_KERNEL_CODE;
+    idt[vector].zero = 0;
+    idt[vector].flags = flags;
+}
+
+void idt_register_handler(uint8_t vector, interrupt_handler_t handler) {
+    handlers[vector] = handler;
+}
+
+static void exception_handler(interrupt_frame_t *frame) {
+    const char *name = frame->int_no < 32 ? exception_names[frame->int_no] : "Unknown";
+
+    if ((frame->cs & 3) == GDT_RPL_USER) {
+        /* Fault inside a ring 3 application: kill it and return to its caller */
+        printf("%s in user process at eip=0x%x (err=0x%x), terminating\n",
+               name, frame->eip, frame->err_code);
+        process_exit(-(int)(128 + frame->int_no));
+    }
+
+    printf("KERNEL PANIC: %s (vector %u, err=0x%x) at eip=0x%x\n",
+           name, frame->int_no, frame->err_code, frame->eip);
+    serial_printf("KERNEL PANIC: %s (vector %u, err=0x%x) at eip=0x%x\n",
+                  name, frame->int_no, frame->err_code, frame->eip);
+    serial_flush();
+    for (;;) {
+        __asm__ volatile ("cli; hlt");
+    }
+}
+
+void interrupt_dispatch(interrupt_frame_t *frame) {
+    interrupt_handler_t handler = handlers[frame->int_no & 0xFF];
+    
+    if (frame->int_no >= PIC_IRQ_BASE && frame->int_no < PIC_IRQ_BASE + PIC_IRQ_COUNT) {
+        // Acknowledge first: a handler may refill a device that interrupts again
+        if (pic_ack_irq(frame->int_no - PIC_IRQ_BASE) && handler) {
+            handler(frame);
+        }
+        return;
+    }
+    
+    if (handler) {
+        handler(frame);
+    } else if (frame->int_no < 32) {
+        exception_handler(frame);
+    }
+}
+
+void idt_init(void) {
+    memset(idt, 0, sizeof(idt));
+    memset(handlers, 0, sizeof(handlers));
+
+    for (int i = 0; i < 32; i++) {
+        idt_set_gate(i, isr_stub_table[i], IDT_GATE_INTERRUPT);
+    }
+    
+    pic_init();
+    for (int i = 0; i < PIC_IRQ_COUNT; i++) {
+        idt_set_gate(PIC_IRQ_BASE + i, irq_stub_table[i], IDT_GATE_INTERRUPT);
+    }
+
+    idt_descriptor.limit = sizeof(idt) - 1;
+    idt_descriptor.base = (uint32_t)&idt;
+    idt_flush(&idt_descriptor);
+}
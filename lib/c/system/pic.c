@@ -0,0 +1,64 @@
+#include <system/pic.h>
+#include <ioport.h>
+
+#define PIC_EOI        0x20
+#define PIC_READ_ISR   0x0B
+#define ICW1_INIT      0x10
+#define ICW1_ICW4      0x01
+#define ICW4_8086      0x01
+
+void pic_init(void) {
+    // ICW1: start initialisation, ICW4 follows
+    outb(PIC1_COMMAND, ICW1_INIT | ICW1_ICW4);
+    io_wait();
+    outb(PIC2_COMMAND, ICW1_INIT | ICW1_ICW4);
+    io_wait();
+    
+    // ICW2: vector offsets
+    outb(PIC1_DATA, PIC_IRQ_BASE);
+    io_wait();
+    outb(PIC2_DATA, PIC_IRQ_BASE + 8);
+    io_wait();
+    
+    // ICW3: slave on IRQ 2
+    outb(PIC1_DATA, 1 << IRQ_CASCADE);
+    io_wait();
+    outb(PIC2_DATA, IRQ_CASCADE);
+    io_wait();
+    
+    // ICW4: 8086 mode
+    outb(PIC1_DATA, ICW4_8086);
+    io_wait();
+    outb(PIC2_DATA, ICW4_8086);
+    io_wait();
+    
+    // Everything masked until a driver asks for its line; the cascade stays open
+    outb(PIC1_DATA, (uint8_t)~(1 << IRQ_CASCADE));
+    outb(PIC2_DATA, 0xFF);
+}
+
+void pic_enable_irq(uint8_t irq) {
+    uint16_t port = irq < 8 ? PIC1_DATA : PIC2_DATA;
+    outb(port, inb(port) & ~(1 << (irq & 7)));
+}
+
+void pic_disable_irq(uint8_t irq) {
+    uint16_t port = irq < 8 ? PIC1_DATA : PIC2_DATA;
+    outb(port, inb(port) | (1 << (irq & 7)));
+}
+
+int pic_ack_irq(uint8_t irq) {
+    // IRQ 7 and 15 fire spuriously; a real one is set in the in-service register
+    if ((irq & 7) == 7) {
+        uint16_t command = irq < 8 ? PIC1_COMMAND : PIC2_COMMAND;
+        outb(command, PIC_READ_ISR);
+        if (!(inb(command) & 0x80)) {
+            if (irq >= 8) outb(PIC1_COMMAND, PIC_EOI);  // master still saw the cascade
+            return 0;
+        }
+    }
+    
+    if (irq >= 8) outb(PIC2_COMMAND, PIC_EOI);
+    outb(PIC1_COMMAND, PIC_EOI);
+    return 1;
+}
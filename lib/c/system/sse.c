@@ -0,0 +1,52 @@
+#include <system/sse.h>
+#include <system/cpu.h>
+#include <stdio.h>
+
+static int sse_state = 0;
+
+/* Register state right after initialisation, loaded into new processes */
+static sse_state_t sse_clean_state;
+
+static inline void *fx_area(const sse_state_t *state) {
+    return (void *)(((uintptr_t)state->area + 15) & ~(uintptr_t)15);
+}
+
+bool sse_init(void) {
+    sse_state = 0;
+    if (!cpu_has_feature_edx(CPUID_EDX_FXSR | CPUID_EDX_SSE | CPUID_EDX_SSE2)) {
+        printf("SSE: not available\n");
+        return false;
+    }
+    
+    // Native FPU with WAIT honouring TS; no lazy switching, so TS stays clear
+    uint32_t cr0 = cpu_read_cr0();
+    cr0 &= ~(CR0_EM | CR0_TS);
+    cr0 |= CR0_MP;
+    cpu_write_cr0(cr0);
+    
+    cpu_write_cr4(cpu_read_cr4() | CR4_OSFXSR | CR4_OSXMMEXCPT);
+    
+    __asm__ volatile ("fninit");
+    cpu_fxsave(fx_area(&sse_clean_state));
+    
+    sse_state = 1;
+    string_use_sse(true);
+    printf("SSE: enabled (SSE2)\n");
+    return true;
+}
+
+bool sse_enabled(void) {
+    return sse_state > 0;
+}
+
+void sse_save(sse_state_t *state) {
+    if (sse_state > 0) cpu_fxsave(fx_area(state));
+}
+
+void sse_restore(const sse_state_t *state) {
+    if (sse_state > 0) cpu_fxrstor(fx_area(state));
+}
+
+void sse_reset(void) {
+    if (sse_state > 0) cpu_fxrstor(fx_area(&sse_clean_state));
+}
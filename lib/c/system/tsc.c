@@ -0,0 +1,75 @@
+#include <system/tsc.h>
+#include <system/cpu.h>
+#include <system/pit.h>
+#include <ioport.h>
+#include <stdio.h>
+
+/* Port 0x61 controls the counter 2 gate and reports its output */
+#define PIT_CH2_CTRL_PORT  0x61
+#define PIT_CH2_GATE       0x01
+#define PIT_CH2_SPEAKER    0x02
+#define PIT_CH2_OUT        0x20
+
+/* Mode 0: output goes high once the count reaches zero */
+#define PIT_INTERRUPT_ON_TC_MODE 0x00
+
+static uint32_t tsc_khz = 0;
+static int tsc_present = 0;
+
+/**
+ * tsc_measure_gate - Counts TSC cycles during one PIT counter 2 countdown
+ */
+static uint64_t tsc_measure_gate(uint16_t latch) {
+    uint8_t saved = inb(PIT_CH2_CTRL_PORT);
+    
+    // Gate high, speaker off
+    outb(PIT_CH2_CTRL_PORT, (saved & ~PIT_CH2_SPEAKER) | PIT_CH2_GATE);
+    outb(PIT_REG_COMMAND, PIT_SELECT_COUNTER_2 | PIT_WRITE_LSB_MSB |
+                          PIT_INTERRUPT_ON_TC_MODE | PIT_BINARY_MODE);
+    outb(PIT_REG_COUNTER_2, (uint8_t)(latch & 0xFF));
+    outb(PIT_REG_COUNTER_2, (uint8_t)(latch >> 8));
+    
+    // Counting starts with the MSB write
+    uint64_t start = cpu_rdtsc();
+    while ((inb(PIT_CH2_CTRL_PORT) & PIT_CH2_OUT) == 0) {
+    }
+    uint64_t end = cpu_rdtsc();
+    
+    outb(PIT_CH2_CTRL_PORT, saved);
+    return end - start;
+}
+
+void tsc_init(void) {
+    tsc_present = cpu_has_feature_edx(CPUID_EDX_TSC);
+    if (!tsc_present) {
+        printf("TSC: not available\n");
+        return;
+    }
+    
+    uint16_t latch = (uint16_t)(PIT_FREQUENCY / (1000 / TSC_CALIBRATE_MS));
+    
+    // Take the shortest of a few runs; longer ones were disturbed
+    uint64_t best = 0;
+    for (int i = 0; i < 3; i++) {
+        uint64_t cycles = tsc_measure_gate(latch);
+        if (best == 0 || cycles < best) {
+            best = cycles;
+        }
+    }
+    
+    tsc_khz = (uint32_t)(best / TSC_CALIBRATE_MS);
+    printf("TSC: %u kHz\n", tsc_khz);
+}
+
+uint64_t tsc_read(void) {
+    return tsc_present ? cpu_rdtsc() : 0;
+}
+
+uint32_t tsc_get_khz(void) {
+    return tsc_khz;
+}
+
+uint64_t tsc_cycles_to_us(uint64_t cycles) {
+    if (tsc_khz == 0) return 0;
+    return cycles * 1000 / tsc_khz;
+}
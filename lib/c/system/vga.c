@@ -1,15 +1,82 @@
 #include <vga.h>
 #include <ioport.h>
 
-// Sets the cursor position
-// offset = row * VGA_WIDTH + col
-void vga_set_cursor(uint16_t offset) {
-    // Write directly to hardware (no VGA_WIDTH addition!)
+// Shadow of the cursor position; each port access is slow (a VM exit under QEMU)
+static uint16_t cursor_shadow = 0;
+static bool cursor_known = false;
+
+// Cell offset of the visible window in text memory
+static uint16_t window_start = 0;
+
+// Reads the cursor position from the hardware, relative to the window
+static uint16_t vga_read_hw_cursor(void) {
+    uint16_t cursor_hw = 0;
     outb(0x3D4, 0x0E);
-    outb(0x3D5, (offset >> 8) & 0xFF);
+    cursor_hw = (uint16_t)inb(0x3D5) << 8;
+    outb(0x3D4, 0x0F);
+    cursor_hw |= inb(0x3D5);
+    return cursor_hw - window_start;
+}
+
+// Writes the hardware cursor; it is addressed in text memory, not in the window
+static void vga_write_hw_cursor(uint16_t offset) {
+    uint16_t pos = window_start + offset;
+    outb(0x3D4, 0x0E);
+    outb(0x3D5, (pos >> 8) & 0xFF);
     
     outb(0x3D4, 0x0F);
-    outb(0x3D5, offset & 0xFF);
+    outb(0x3D5, pos & 0xFF);
+}
+
+volatile uint16_t *vga_text_window(void) {
+    return VGA_TEXT_BASE + window_start;
+}
+
+uint16_t vga_get_window(void) {
+    return window_start;
+}
+
+// Pans the display: CRTC start address high (0x0C) and low (0x0D)
+void vga_set_window(uint16_t start) {
+    window_start = start;
+    
+    outb(0x3D4, 0x0C);
+    outb(0x3D5, (start >> 8) & 0xFF);
+    outb(0x3D4, 0x0D);
+    outb(0x3D5, start & 0xFF);
+    
+    // Keep the cursor on the same screen cell
+    if (cursor_known) {
+        vga_write_hw_cursor(cursor_shadow);
+    }
+}
+
+void vga_reset_window(void) {
+    if (window_start == 0) return;
+    
+    volatile uint16_t *src = VGA_TEXT_BASE + window_start;
+    volatile uint16_t *dst = VGA_TEXT_BASE;
+    for (int i = 0; i < VGA_WIDTH * VGA_HEIGHT; i++) {
+        dst[i] = src[i];
+    }
+    vga_set_window(0);
+}
+
+// Sets the cursor position
+// offset = row * VGA_WIDTH + col
+void vga_set_cursor(uint16_t offset) {
+    if (cursor_known && offset == cursor_shadow) {
+        return;  // Hardware is already there
+    }
+    cursor_shadow = offset;
+    cursor_known = true;
+    vga_write_hw_cursor(offset);
+}
+
+// Reloads the shadow after code with its own copy of this driver moved the cursor
+void vga_resync_cursor(void) {
+    cursor_shadow = vga_read_hw_cursor();
+    cursor_known = true;
 }
 
 // Shows the cursor
@@ -29,6 +96,10 @@ void vga_hide_cursor(void) {
 }
 
 void vga_clear(enum vga_color fg, enum vga_color bg, bool show_cursor, int cursor_position) {
+    if (window_start != 0) {
+        vga_set_window(0);
+    }
+    
     volatile uint16_t* vga = VGA_MEMORY;
     uint16_t blank = vga_entry(0x00, fg, bg);
 
@@ -44,13 +115,12 @@ void vga_clear(enum vga_color fg, enum vga_color bg, bool show_cursor, int curso
     }
 }
 
+// Returns the cursor position from the shadow, reading the hardware only once
 uint16_t vga_get_cursor_position(void) {
-    uint16_t cursor_hw = 0;
-    outb(0x3D4, 0x0E);
-    cursor_hw = (uint16_t)inb(0x3D5) << 8;
-    outb(0x3D4, 0x0F);
-    cursor_hw |= inb(0x3D5);
-    return cursor_hw;
+    if (!cursor_known) {
+        vga_resync_cursor();
+    }
+    return cursor_shadow;
 }
 
 uint16_t vga_increment_cursor_position(void) {
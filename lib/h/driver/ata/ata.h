@@ -37,6 +37,14 @@ typedef struct {
 
 } ata_device_t;
 
+/* Cumulative I/O counters for successful transfers */
+typedef struct {
+    uint32_t read_commands;
+    uint32_t write_commands;
+    uint32_t sectors_read;
+    uint32_t sectors_written;
+} ata_io_stats_t;
+
 /**
  * Initialize ATA driver
  */
@@ -63,4 +71,9 @@ void ata_print_devices(void);
 bool ata_read_sectors_lba28(uint32_t lba, uint8_t count, void *buf);
 bool ata_write_sectors_lba28(uint32_t lba, uint8_t count, const void *buf);
 
+/**
+ * Get cumulative I/O counters since boot
+ */
+void ata_get_io_stats(ata_io_stats_t *out);
+
 #endif /* _ATA_H */
@@ -0,0 +1,40 @@
+#ifndef _SERIAL_H
+#define _SERIAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* COM1 16550 registers (offsets from SERIAL_COM1) */
+#define SERIAL_COM1        0x3F8
+#define SERIAL_DATA        0   /* THR/RBR, divisor low with DLAB */
+#define SERIAL_IER         1   /* Interrupt enable, divisor high with DLAB */
+#define SERIAL_FCR         2   /* FIFO control (write) */
+#define SERIAL_LCR         3
+#define SERIAL_MCR         4
+#define SERIAL_LSR         5
+
+#define SERIAL_LSR_THRE    0x20
+#define SERIAL_IER_THRE    0x02
+
+/* 115200 baud: 115200 / divisor */
+#define SERIAL_DIVISOR     1
+#define SERIAL_FIFO_DEPTH  16
+#define SERIAL_TX_RING     16384
+
+/**
+ * Program COM1 (115200 8N1, FIFOs on) and start interrupt-driven output.
+ * Until this runs, serial_write polls the line.
+ */
+void serial_init(void);
+
+/**
+ * Spin until everything queued has left the transmitter
+ */
+void serial_flush(void);
+
+/**
+ * Bytes dropped because the TX ring was full
+ */
+uint32_t serial_get_dropped(void);
+
+#endif
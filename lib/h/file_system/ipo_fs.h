@@ -5,20 +5,34 @@
 #include <stdbool.h>
 #include <stddef.h>
 
-#define IPO_FS_BLOCK_SIZE 512
+/* Blocks are 1..16 sectors; sb.block_size is the one in use */
+#define IPO_FS_SECTOR_SIZE 512
+#define IPO_FS_MAX_BLOCK_SIZE 8192
+#define IPO_FS_DEFAULT_BLOCK_SIZE 4096
 #define IPO_FS_MAX_NAME 64
 #define IPO_FS_DIRECT_BLOCKS 6
 #define IPO_FS_MAGIC_STR "IPO_FS"
 
+/* Superblock revision; 0 predates every field after data_blocks_start */
+#define IPO_FS_REVISION 1
+
+/* feature flags (sb.features) */
+#define IPO_FS_FEATURE_LAZY_INIT 0x1 /* bitmaps and inode table zeroed on first use */
+#define IPO_FS_FEATURE_EXTENTS   0x2 /* new files are extent mapped */
+#define IPO_FS_FEATURE_DIR_INDEX 0x4 /* large directories keep a name hash index */
+#define IPO_FS_FEATURES_KNOWN    (IPO_FS_FEATURE_LAZY_INIT | IPO_FS_FEATURE_EXTENTS | IPO_FS_FEATURE_DIR_INDEX)
+
 /* inode types/flags */
 #define IPO_INODE_TYPE_DIR 0x1
 #define IPO_INODE_TYPE_FILE 0x2
 #define IPO_INODE_FLAG_PROTECTED 0x80000000u
+#define IPO_INODE_FLAG_EXTENTS   0x40000000u /* data mapped by an extent tree, not block pointers */
 
 #define IPO_MAX_FDS 32
 
 struct ipo_superblock {
-    char magic[8];
+    char magic[7];
+    uint8_t revision;
     uint32_t fs_size_blocks;
     uint32_t block_size;
     uint32_t inode_count;
@@ -26,16 +40,58 @@ struct ipo_superblock {
     uint32_t block_bitmap_start;
     uint32_t inode_table_start;
     uint32_t data_blocks_start;
+    /* revision 1 */
+    uint32_t features;
+    /* lazy init high-water marks: blocks zeroed from the start of each region */
+    uint32_t inode_bitmap_init;
+    uint32_t block_bitmap_init;
+    uint32_t inode_table_init;
+};
+
+/*
+ * Extent tree node: a header followed by entries sorted by logical block.
+ * Leaves (depth 0) map length blocks from logical to physical; index
+ * entries point physical at the child node covering blocks from logical.
+ */
+#define IPO_EXTENT_MAGIC 0xE47E
+#define IPO_EXTENT_ROOT_MAX 2
+
+struct ipo_extent_header {
+    uint16_t magic;
+    uint16_t entries;
+    uint16_t max;
+    uint16_t depth;
+};
+
+struct ipo_extent {
+    uint32_t logical;
+    uint32_t physical;
+    uint32_t length; /* 0 in index nodes */
 };
 
 struct ipo_inode {
     uint32_t mode; /* type and flags */
     uint32_t size;
     uint32_t links_count;
-    uint32_t direct[IPO_FS_DIRECT_BLOCKS];
-    uint32_t indirect;
-    uint32_t double_indirect;
-    uint8_t  _pad[32]; /* padding to make inode reasonably sized */
+    union {
+        struct {
+            uint32_t direct[IPO_FS_DIRECT_BLOCKS];
+            uint32_t indirect;
+            uint32_t double_indirect;
+        };
+        /* IPO_INODE_FLAG_EXTENTS: root of the extent tree */
+        struct {
+            struct ipo_extent_header extent_root;
+            struct ipo_extent extents[IPO_EXTENT_ROOT_MAX];
+        };
+    };
+    uint32_t generation; /* bumped on every write and on inode reuse */
+    /* directories: hash index in index_blocks contiguous blocks from index_start, 0 if none */
+    uint32_t index_start;
+    uint32_t index_blocks;
+    uint32_t index_used;    /* slots naming a live entry */
+    uint32_t index_deleted; /* slots left behind by removed entries */
+    uint8_t  _pad[12]; /* padding to make inode reasonably sized */
 };
 
 struct ipo_dir_entry {
@@ -46,6 +102,18 @@ struct ipo_dir_entry {
     char name[IPO_FS_MAX_NAME];
 };
 
+/*
+ * Directory hash index: an open-addressed table of slots probed linearly
+ * from hash % slot count. entry is the directory entry number plus one;
+ * 0 marks a free slot and IPO_DIR_INDEX_DELETED one that was removed.
+ */
+#define IPO_DIR_INDEX_DELETED 0xFFFFFFFFu
+
+struct ipo_dir_index_slot {
+    uint32_t hash;
+    uint32_t entry;
+};
+
 /* file descriptor */
 struct ipo_fd {
     int used;
@@ -63,10 +131,23 @@ extern struct ipo_fd fds[IPO_MAX_FDS];
 /* Block layer */
 bool block_read(uint32_t fs_block_index, void *buffer);
 bool block_write(uint32_t fs_block_index, const void *buffer);
+bool blocks_read(uint32_t fs_block_index, uint32_t count, void *buffer);
+bool blocks_write(uint32_t fs_block_index, uint32_t count, const void *buffer);
+bool superblock_write(void);
+bool ipo_fs_lazy_init_step(uint32_t max_blocks);
 
 /* Bitmap API */
 bool bitmap_get(uint32_t bitmap_start, uint32_t bit_index);
 bool bitmap_set(uint32_t bitmap_start, uint32_t bit_index, bool value);
+int bitmap_find_free(uint32_t bitmap_start, uint32_t bit_count, uint32_t hint);
+int bitmap_find_free_run(uint32_t bitmap_start, uint32_t bit_count, uint32_t run_len, uint32_t hint);
+
+/* What get_data_run_for_inode does with unmapped blocks */
+typedef enum {
+    IPO_MAP_LOOKUP = 0,     /* the run ends there */
+    IPO_MAP_ALLOC,          /* allocate zeroed blocks */
+    IPO_MAP_OVERWRITE       /* allocate without zeroing: the caller writes all of them */
+} ipo_map_mode_t;
 
 /* Inode API */
 bool read_inode(uint32_t inode_no, struct ipo_inode *out);
@@ -74,24 +155,65 @@ bool write_inode(uint32_t inode_no, const struct ipo_inode *in);
 int allocate_inode(void);
 bool free_inode(uint32_t inode_no);
 int allocate_block(void);
+int allocate_block_near(uint32_t goal, bool zero);
+int allocate_blocks(uint32_t count);
 bool free_block(uint32_t phys_block);
 int get_data_block_for_inode(struct ipo_inode *inode, uint32_t logical_index, bool alloc);
+int get_data_run_for_inode(struct ipo_inode *inode, uint32_t logical_index, uint32_t max_blocks, ipo_map_mode_t mode, uint32_t *out_run);
+
+/* Extent API (IPO_INODE_FLAG_EXTENTS inodes) */
+void extent_init(struct ipo_inode *inode);
+int extent_map(const struct ipo_inode *inode, uint32_t logical, uint32_t *out_run);
+int extent_map_alloc(struct ipo_inode *inode, uint32_t logical, bool zero);
+bool extent_free_all(struct ipo_inode *inode);
+
+/*
+ * Directory iterator: walks the live entries of a directory reading each
+ * of its blocks once. entry points into buf, which holds directory block
+ * block; index is the entry's number within the directory.
+ */
+typedef struct {
+    uint8_t buf[IPO_FS_MAX_BLOCK_SIZE];
+    uint8_t indirect[IPO_FS_MAX_BLOCK_SIZE];
+    struct ipo_inode din;
+    uint32_t entries;
+    uint32_t next;
+    uint32_t index;
+    uint32_t block;
+    struct ipo_dir_entry *entry;
+    bool failed; /* a block could not be read */
+    bool indirect_loaded;
+} dir_iter_t;
 
 /* Directory / path */
+void dir_iter_begin(dir_iter_t *it, const struct ipo_inode *din);
+bool dir_iter_next(dir_iter_t *it);
+bool dir_is_empty(const struct ipo_inode *din);
 int dir_find_entry(uint32_t dir_inode_no, const char *name, struct ipo_dir_entry *out_entry, uint32_t *out_block, uint32_t *out_block_off);
 bool is_valid_filename(const char *name);
 bool dir_add_entry(uint32_t dir_inode_no, const char *name, uint32_t inode_no, uint8_t type);
 bool dir_remove_entry(uint32_t dir_inode_no, const char *name);
+bool dir_entry_matches(const struct ipo_dir_entry *de, const char *name);
 void fs_canonicalize(const char *in, char *out, size_t out_size);
 int path_resolve_parent(const char *path, uint32_t *out_parent_inode, char *out_name);
 int path_resolve(const char *path, uint32_t *out_inode);
 
+/* Directory hash index (IPO_FS_FEATURE_DIR_INDEX) */
+uint32_t dir_name_hash(const char *name, size_t len);
+bool dir_index_active(const struct ipo_inode *din);
+int dir_index_lookup(struct ipo_inode *din, const char *name, uint32_t *out_entry_no, uint32_t *out_block, void *block_buf);
+void dir_index_add(struct ipo_inode *din, const char *name, uint32_t entry);
+void dir_index_remove(struct ipo_inode *din, const char *name, uint32_t entry);
+void dir_index_free(struct ipo_inode *din);
+
 /* Public FS API */
 void ipo_fs_init(void);
-bool ipo_fs_format(uint32_t disk_start_lba, uint32_t total_blocks, uint32_t total_inodes);
+bool ipo_fs_format(uint32_t disk_start_lba, uint32_t total_sectors, uint32_t total_inodes, uint32_t block_size);
 bool ipo_fs_mount(uint32_t disk_start_lba);
 int ipo_fs_create(const char *path, uint8_t type);
 int ipo_fs_open(const char *path);
+int ipo_fs_open_inode(uint32_t inode_no);
+bool ipo_fs_close(int fd);
 int ipo_fs_read(int fd, void *buffer, uint32_t size, uint32_t offset);
 int ipo_fs_write(int fd, const void *buffer, uint32_t size, uint32_t offset);
 bool ipo_fs_delete(const char *path);
@@ -0,0 +1,29 @@
+#ifndef KERNEL_ARGV_H
+#define KERNEL_ARGV_H
+
+/*
+ * Argument blocks: one allocation holding the argv pointer array
+ * (argc + 1 entries, NULL-terminated) followed by the packed strings.
+ * A block is released with a single kfree() of the returned pointer.
+ */
+
+/**
+ * argv_block_from_cmdline - Tokenizes a command line into an argument block
+ *
+ * Tokens are separated by spaces, tabs and line breaks. At most
+ * MAX_ARGV_COUNT tokens are kept and each is cut to MAX_ARG_LENGTH - 1
+ * characters.
+ * Returns the block (NULL for an empty line or on allocation failure)
+ * and stores the token count in argc_out.
+ */
+char **argv_block_from_cmdline(const char *cmdline, int *argc_out);
+
+/**
+ * argv_block_pack - Copies an existing argv array into an argument block
+ *
+ * Stops at the first NULL entry or at MAX_ARGV_COUNT entries.
+ * Returns the block and stores the number of entries copied in argc_out.
+ */
+char **argv_block_pack(int argc, char **argv, int *argc_out);
+
+#endif
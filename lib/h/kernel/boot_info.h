@@ -0,0 +1,92 @@
+#ifndef KERNEL_BOOT_INFO_H
+#define KERNEL_BOOT_INFO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <kernel/sink.h>
+
+// Multiboot (version 1) header, as placed in the kernel by entry32.asm
+#define MULTIBOOT_HEADER_MAGIC     0x1BADB002
+#define MULTIBOOT_BOOTLOADER_MAGIC 0x2BADB002  // EAX at entry
+
+#define MULTIBOOT_INFO_MEMORY  0x001
+#define MULTIBOOT_INFO_CMDLINE 0x004
+#define MULTIBOOT_INFO_MMAP    0x040
+#define MULTIBOOT_INFO_LOADER  0x200
+
+#define MULTIBOOT_MEMORY_AVAILABLE 1
+
+// Leading part of the structure EBX points to at entry
+typedef struct {
+    uint32_t flags;
+    uint32_t mem_lower;     // KB below 1 MB
+    uint32_t mem_upper;     // KB above 1 MB
+    uint32_t boot_device;
+    uint32_t cmdline;
+    uint32_t mods_count;
+    uint32_t mods_addr;
+    uint32_t syms[4];
+    uint32_t mmap_length;
+    uint32_t mmap_addr;
+    uint32_t drives_length;
+    uint32_t drives_addr;
+    uint32_t config_table;
+    uint32_t boot_loader_name;
+} __attribute__((packed)) multiboot_info_t;
+
+// size does not count itself; entries are size + 4 bytes apart
+typedef struct {
+    uint32_t size;
+    uint64_t addr;
+    uint64_t len;
+    uint32_t type;
+} __attribute__((packed)) multiboot_mmap_entry_t;
+
+#define BOOT_MMAP_MAX     32
+#define BOOT_CMDLINE_MAX  256
+#define BOOT_LOADER_MAX   64
+
+typedef struct {
+    uint64_t addr;
+    uint64_t len;
+    uint32_t type;
+} boot_mmap_entry_t;
+
+// What the kernel learned from its loader, copied out of loader memory
+typedef struct {
+    int multiboot;                      // 1 if entered through Multiboot
+    char loader[BOOT_LOADER_MAX];
+    char cmdline[BOOT_CMDLINE_MAX];
+    uint32_t mem_lower_kb;
+    uint32_t mem_upper_kb;
+    uint32_t mmap_count;
+    boot_mmap_entry_t mmap[BOOT_MMAP_MAX];
+} boot_info_t;
+
+/**
+ * boot_info_init - Copies the Multiboot information passed at entry
+ *
+ * Must run before anything allocates: the loader's structures live in
+ * memory the kernel does not reserve. Any other magic means the kernel
+ * came through the disk bootloader, which passes nothing.
+ */
+void boot_info_init(uint32_t magic, uint32_t info_addr);
+
+/**
+ * boot_info_get - Returns the information collected at boot
+ */
+const boot_info_t *boot_info_get(void);
+
+/**
+ * boot_cmdline_value - Looks up key=value on the kernel command line
+ *
+ * Returns 1 and copies the value into out, or 0 if the key is absent.
+ */
+int boot_cmdline_value(const char *key, char *out, size_t size);
+
+/**
+ * boot_info_print - Writes the loader, command line and memory map to out
+ */
+void boot_info_print(sink_t *out);
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef KERNEL_BOOT_TIMELINE_H
+#define KERNEL_BOOT_TIMELINE_H
+
+#include <stdint.h>
+#include <kernel/sink.h>
+
+#define BOOT_STAGE_MAX 32
+
+/*
+ * Stage names are kept by pointer, so they must be string literals.
+ * Timestamps are raw TSC cycles since reset and are converted once
+ * tsc_init has calibrated the frequency.
+ */
+typedef struct {
+    const char *name;
+    uint64_t start;
+    uint64_t end;
+    int repeated;       // the same stage already ran earlier in the boot
+} boot_stage_t;
+
+/**
+ * boot_timeline_start - Records kernel entry; firmware and loaders end here
+ */
+void boot_timeline_start(void);
+
+/**
+ * boot_timeline_mark - Ends the current stage, which began at the previous mark
+ *
+ * A stage name seen before is flagged and warned about: init code that runs
+ * twice is almost always a mistake.
+ */
+void boot_timeline_mark(const char *name);
+
+/**
+ * boot_timeline_print - Writes each stage's duration and share of the boot to out
+ */
+void boot_timeline_print(sink_t *out);
+
+/**
+ * boot_timeline_dump_serial - Writes the timeline to COM1, one stage per line
+ *
+ * Format: "boottime <index> <name> <start_us> <duration_us>[ repeated]",
+ * followed by "boottime total <total_us>".
+ */
+void boot_timeline_dump_serial(void);
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef KERNEL_IMAGE_CACHE_H
+#define KERNEL_IMAGE_CACHE_H
+
+#include <stdint.h>
+
+// Limits for cached executable images
+#define IMAGE_CACHE_MAX_ENTRIES 32
+#define IMAGE_CACHE_BUDGET      (8 * 1024 * 1024)  // 8 MB of cached images
+
+/**
+ * image_cache_init - Drops every cached image and resets the counters
+ */
+void image_cache_init(void);
+
+/**
+ * image_cache_lookup - Finds a validated image
+ *
+ * An entry matches only if inode, size and generation all match; a stale
+ * entry for the same inode is released on the spot.
+ * Returns the cached image or NULL.
+ */
+const void *image_cache_lookup(uint32_t inode, uint32_t size, uint32_t generation);
+
+/**
+ * image_cache_insert - Hands a validated image over to the cache
+ *
+ * Evicts least recently used entries until the image fits the budget.
+ * Returns 1 if the cache took ownership of image, 0 if the caller keeps it.
+ */
+int image_cache_insert(uint32_t inode, uint32_t size, uint32_t generation, void *image);
+
+/**
+ * image_cache_invalidate - Releases any image cached for the inode
+ */
+void image_cache_invalidate(uint32_t inode);
+
+/**
+ * image_cache_get_stats - Reports hit/miss counters and memory in use
+ */
+void image_cache_get_stats(uint32_t *hits, uint32_t *misses, uint32_t *bytes);
+
+#endif
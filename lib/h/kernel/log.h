@@ -0,0 +1,110 @@
+#ifndef KERNEL_LOG_H
+#define KERNEL_LOG_H
+
+#include <stdint.h>
+
+/* Severity levels, most severe first */
+#define LOG_LEVEL_NONE   0
+#define LOG_LEVEL_ERROR  1
+#define LOG_LEVEL_WARN   2
+#define LOG_LEVEL_INFO   3
+#define LOG_LEVEL_DEBUG  4
+#define LOG_LEVEL_TRACE  5
+
+/*
+ * Messages above LOG_COMPILE_LEVEL are removed by the preprocessor,
+ * arguments included; the rest cost one byte compare when disabled at
+ * run time. Override with -DLOG_COMPILE_LEVEL=n (LOG_LEVEL in mk/config.mk).
+ */
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+/* Level each subsystem starts with; changed at run time with log_set_level */
+#define LOG_DEFAULT_LEVEL LOG_LEVEL_WARN
+
+typedef enum {
+    LOG_KERNEL,
+    LOG_PROC,
+    LOG_FS,
+    LOG_ATA,
+    LOG_SUBSYSTEM_COUNT
+} log_subsystem_t;
+
+/* Run-time level of each subsystem, read inline by the LOG_* macros */
+extern uint8_t log_levels[LOG_SUBSYSTEM_COUNT];
+
+#define LOG_AT(sub, level, ...) \
+    do { \
+        if ((level) <= log_levels[sub]) \
+            log_write((sub), (level), __VA_ARGS__); \
+    } while (0)
+
+#define LOG_NOTHING() do { } while (0)
+
+#if LOG_COMPILE_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERR(sub, ...)   LOG_AT(sub, LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERR(sub, ...)   LOG_NOTHING()
+#endif
+
+#if LOG_COMPILE_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(sub, ...)  LOG_AT(sub, LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(sub, ...)  LOG_NOTHING()
+#endif
+
+#if LOG_COMPILE_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(sub, ...)  LOG_AT(sub, LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(sub, ...)  LOG_NOTHING()
+#endif
+
+#if LOG_COMPILE_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(sub, ...) LOG_AT(sub, LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(sub, ...) LOG_NOTHING()
+#endif
+
+#if LOG_COMPILE_LEVEL >= LOG_LEVEL_TRACE
+#define LOG_TRACE(sub, ...) LOG_AT(sub, LOG_LEVEL_TRACE, __VA_ARGS__)
+#else
+#define LOG_TRACE(sub, ...) LOG_NOTHING()
+#endif
+
+/**
+ * log_write - Formats and emits one message; use the LOG_* macros instead
+ * Every message goes to serial with a "[tag] " prefix; errors and warnings
+ * are also shown on the console.
+ */
+void log_write(log_subsystem_t sub, int level, const char *format, ...)
+    __attribute__((format(printf, 3, 4)));
+
+/**
+ * log_set_level - Sets the run-time level of one subsystem
+ */
+void log_set_level(log_subsystem_t sub, int level);
+
+/**
+ * log_subsystem_name - Short tag of a subsystem ("fs", "ata", ...)
+ */
+const char *log_subsystem_name(log_subsystem_t sub);
+
+/**
+ * log_level_name - Name of a level ("error", "debug", ...)
+ */
+const char *log_level_name(int level);
+
+/**
+ * log_find_subsystem - Looks up a subsystem by tag
+ * Returns the subsystem, or -1 if unknown.
+ */
+int log_find_subsystem(const char *name);
+
+/**
+ * log_parse_level - Parses a level name or digit
+ * Returns the level, or -1 if invalid.
+ */
+int log_parse_level(const char *name);
+
+#endif
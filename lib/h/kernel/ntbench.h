@@ -0,0 +1,23 @@
+#ifndef KERNEL_NTBENCH_H
+#define KERNEL_NTBENCH_H
+
+#include <stdint.h>
+#include <kernel/sink.h>
+
+/*
+ * memcpy/memset only take the SSE2 non-temporal path in the kernel:
+ * applications keep a scalar copy of the string routines. This measures
+ * both paths from ring 0 on the sizes that reach the streaming code.
+ */
+
+/**
+ * ntbench_run - Reports memcpy and memset MB/s with and without streaming
+ *
+ * Moves mb megabytes per measurement and writes one line per routine and
+ * size to out: "ntbench <routine> <KB> KB rep <MB/s> nt <MB/s> MB/s".
+ * Returns false if the TSC is not calibrated or the buffers could not
+ * be allocated.
+ */
+bool ntbench_run(sink_t *out, uint32_t mb);
+
+#endif
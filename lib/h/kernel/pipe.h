@@ -0,0 +1,53 @@
+#ifndef KERNEL_PIPE_H
+#define KERNEL_PIPE_H
+
+#include <stdint.h>
+
+// Default capacity of a pipe between two pipeline stages
+#define PIPE_DEFAULT_CAPACITY (1024 * 1024)  // 1 MB
+
+/*
+ * Pipes are bounded byte ring buffers. Pipeline stages run one after
+ * another, so a reader never waits for a live writer: reading an empty
+ * pipe whose write end is closed returns 0 (end of file), and writing a
+ * full pipe returns a short count instead of waiting for a reader that
+ * can only run later.
+ */
+typedef struct pipe {
+    uint8_t *data;
+    uint32_t capacity;
+    uint32_t head;          // Read position
+    uint32_t count;         // Bytes buffered
+    uint32_t dropped;       // Bytes refused because the pipe was full
+    uint8_t write_closed;   // No more data will arrive
+} pipe_t;
+
+/**
+ * pipe_create - Allocates a pipe able to buffer capacity bytes
+ * Returns NULL on allocation failure.
+ */
+pipe_t *pipe_create(uint32_t capacity);
+
+/**
+ * pipe_destroy - Releases the pipe and its buffer
+ */
+void pipe_destroy(pipe_t *pipe);
+
+/**
+ * pipe_write - Appends up to len bytes
+ * Returns the number of bytes accepted, or -1 if the write end is closed.
+ */
+int pipe_write(pipe_t *pipe, const void *buf, uint32_t len);
+
+/**
+ * pipe_read - Removes up to len bytes
+ * Returns the number of bytes read; 0 means end of file.
+ */
+int pipe_read(pipe_t *pipe, void *buf, uint32_t len);
+
+/**
+ * pipe_close_write - Marks the end of the data
+ */
+void pipe_close_write(pipe_t *pipe);
+
+#endif
@@ -2,6 +2,12 @@
 #define KERNEL_PROCESS_H
 
 #include <stdint.h>
+#include <stddef.h>
+#include <kernel/syscall.h>
+#include <driver/ata/ata.h>
+#include <kernel/sink.h>
+#include <kernel/pipe.h>
+#include <system/sse.h>
 
 // Maximum sizes
 #define MAX_PROCESS_SIZE (512 * 1024 * 1024)  // 512 MB max per app
@@ -12,6 +18,7 @@
 #define PROCESS_BASE_ADDR   0x10000000  // Base address for all applications
 #define PROCESS_STACK_TOP   0xC0000000  // Top of the stack
 #define PROCESS_STACK_SIZE  (2 * 1024 * 1024)  // 2MB stack
+#define PROCESS_USER_STACK_SIZE (64 * 1024)    // Stack for ring 3 processes
 
 // Protection flags
 #define PROT_NONE  0
@@ -19,6 +26,29 @@
 #define PROT_WRITE 2
 #define PROT_EXEC  4
 
+// Resource accounting for one process_exec
+typedef struct {
+    uint64_t start_cycles;      // TSC at exec entry (0 without a TSC)
+    uint64_t end_cycles;        // TSC at cleanup
+    uint32_t sectors_read;      // Disk sectors transferred, nested execs included
+    uint32_t sectors_written;
+    uint32_t read_commands;     // ATA commands issued
+    uint32_t write_commands;
+    uint32_t peak_heap;         // Heap high-water mark above the exec baseline
+} process_stats_t;
+
+// Standard streams handed to a new process
+typedef struct {
+    sink_t *out;            // stdout
+    pipe_t *in;             // stdin, NULL for none (reads return end of file)
+} process_io_t;
+
+// Header of a heap block handed to the process by SYS_MALLOC
+typedef struct process_block {
+    struct process_block *next;
+    uint32_t size;          // Usable bytes after the header
+} process_block_t;
+
 // Process structure
 typedef struct process {
     uint32_t pid;
@@ -36,12 +66,30 @@ typedef struct process {
     // Arguments
     int argc;               // Number of arguments
     uint32_t argv_addr;     // Address of argv array in process space
-    char **argv_kernel;     // Copy of argv in kernel space (for debugging)
+    char **argv_kernel;     // Argument block in kernel space (one allocation)
+    uint32_t argv_size;     // Bytes of the argument block in use
+    
+    // Standard streams
+    sink_t *stdout_sink;    // Never NULL while running
+    pipe_t *stdin_pipe;     // NULL when stdin is not redirected
     
     // State
     int exit_code;          // Exit code
     uint8_t is_running;     // Running flag
     
+    // Ring 3 execution
+    uint8_t user_mode;      // Runs in ring 3 through the syscall ABI
+    void *user_stack;       // Stack allocation for ring 3
+    user_context_t user_ctx; // Kernel context to return to on exit
+    process_block_t *blocks; // SYS_MALLOC blocks, most recently used first
+    sse_state_t caller_fpu;  // x87/SSE registers of whoever started this process
+    
+    // Accounting
+    process_stats_t stats;
+    ata_io_stats_t io_base;  // Disk counters at exec entry
+    size_t heap_base;        // Heap bytes in use at exec entry
+    size_t saved_peak;       // Heap peak of the parent, merged back on exit
+    
     // Debugging
     char name[256];         // Process name
     
@@ -55,9 +103,17 @@ typedef int (*ipob_entry_t)(int argc, char **argv);
 // Function prototypes
 void process_init(void);
 int process_exec(const char *path, int argc, char **argv);
+int process_exec_block(const char *path, int argc, char **argv_block, const process_io_t *io);
 int process_exec_simple(const char *path);
 int process_get_exit_code(void);
 process_t *process_get_current(void);
 void process_cleanup(process_t *proc);
+void process_exit(int exit_code);
+void process_get_last_stats(process_stats_t *out);
+sink_t *process_stdout(void);
+pipe_t *process_stdin(void);
+void *process_alloc(process_t *proc, uint32_t size);
+int process_free(process_t *proc, void *ptr);
+uint32_t process_user_span(process_t *proc, uint32_t addr);
 
 #endif
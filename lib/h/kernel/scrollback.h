@@ -0,0 +1,48 @@
+#ifndef KERNEL_SCROLLBACK_H
+#define KERNEL_SCROLLBACK_H
+
+#include <stdint.h>
+
+// Bytes of compressed history kept for the terminal
+#define SCROLLBACK_BYTES (128 * 1024)
+
+/*
+ * Terminal lines that scrolled off the screen, stored compressed in a
+ * byte ring. Each record is [len][payload][len]; the payload is a list
+ * of runs [attribute][count][count characters] with trailing blank cells
+ * dropped. The length at both ends lets the ring be walked either way,
+ * and the oldest records are evicted when a new one does not fit.
+ */
+
+/**
+ * scrollback_clear - Drops all stored lines
+ */
+void scrollback_clear(void);
+
+/**
+ * scrollback_push - Appends one screen line of VGA_WIDTH cells
+ */
+void scrollback_push(const volatile uint16_t *cells);
+
+/**
+ * scrollback_count - Returns the number of stored lines
+ */
+int scrollback_count(void);
+
+/**
+ * scrollback_find - Returns the record of the line age lines back (0 = newest)
+ * age must be below scrollback_count().
+ */
+uint32_t scrollback_find(int age);
+
+/**
+ * scrollback_older - Returns the record stored just before pos
+ */
+uint32_t scrollback_older(uint32_t pos);
+
+/**
+ * scrollback_decode - Expands a record into VGA_WIDTH cells
+ */
+void scrollback_decode(uint32_t pos, uint16_t *cells);
+
+#endif
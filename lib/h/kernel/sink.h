@@ -0,0 +1,92 @@
+#ifndef KERNEL_SINK_H
+#define KERNEL_SINK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <kernel/pipe.h>
+
+// Initial size of the memory buffer behind a file sink
+#define SINK_FILE_INITIAL_SIZE 4096
+
+// Small writes to a pipe are staged and moved in blocks of this size
+#define SINK_BUFFER_SIZE 512
+
+/*
+ * An output sink is where a process's stdout goes: the console, the
+ * serial port, a pipe to the next pipeline stage, or a file opened by
+ * > or >>. Every write reaches the device as one bulk transfer; the
+ * console and serial port see each write right away, pipe and file
+ * output is buffered until sink_flush()/sink_close().
+ */
+typedef enum {
+    SINK_CONSOLE = 0,
+    SINK_SERIAL,
+    SINK_PIPE,
+    SINK_FILE
+} sink_type_t;
+
+typedef struct sink {
+    sink_type_t type;
+    
+    // SINK_PIPE
+    pipe_t *pipe;
+    uint8_t stage[SINK_BUFFER_SIZE];
+    uint32_t staged;
+    
+    // SINK_FILE: output collects in memory and reaches the disk in one write
+    int fd;
+    uint32_t file_offset;   // Where the collected data goes in the file
+    uint8_t *buf;
+    uint32_t len;
+    uint32_t cap;
+} sink_t;
+
+/**
+ * sink_console - Returns the shared console sink
+ */
+sink_t *sink_console(void);
+
+/**
+ * sink_serial - Returns the shared serial port (COM1) sink
+ */
+sink_t *sink_serial(void);
+
+/**
+ * sink_init_pipe - Makes sink write into pipe
+ */
+void sink_init_pipe(sink_t *sink, pipe_t *pipe);
+
+/**
+ * sink_open_file - Makes sink write into a file
+ *
+ * Creates the file if needed. Without append the previous contents are
+ * discarded; with append the output goes after them.
+ * Returns false if the file could not be opened.
+ */
+bool sink_open_file(sink_t *sink, const char *path, bool append);
+
+/**
+ * sink_write - Writes len bytes to the sink
+ * Returns the number of bytes accepted, or -1 on error.
+ */
+int sink_write(sink_t *sink, const void *buf, uint32_t len);
+
+/**
+ * sink_printf - Formats into the sink with the printf conversions
+ * Returns the number of characters produced.
+ */
+int sink_printf(sink_t *sink, const char *format, ...);
+
+/**
+ * sink_flush - Pushes staged pipe output into the pipe
+ * Returns false if the pipe refused part of it.
+ */
+bool sink_flush(sink_t *sink);
+
+/**
+ * sink_close - Flushes the sink and releases its resources
+ * Pipes are left open for their reader. Returns false if data was lost.
+ */
+bool sink_close(sink_t *sink);
+
+#endif
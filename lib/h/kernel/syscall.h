@@ -0,0 +1,80 @@
+#ifndef KERNEL_SYSCALL_H
+#define KERNEL_SYSCALL_H
+
+#include <stdint.h>
+
+/*
+ * System call numbers. This table is the stable ABI between the kernel
+ * and IPOB applications: numbers are never reused or reordered, new
+ * calls are appended before SYS_COUNT.
+ *
+ * int 0x80:  eax = number, ebx/ecx/edx/esi = arguments 1-4
+ * sysenter:  eax = number, ebx/esi/edi/ebp = arguments 1-4,
+ *            ecx = user esp, edx = user return eip
+ * The result is returned in eax, all other registers are preserved.
+ */
+#define SYS_EXIT           0   /* (int code) */
+#define SYS_CONSOLE_WRITE  1   /* (const char *buf, uint32_t len), to stdout */
+#define SYS_OPEN           2   /* (const char *path) */
+#define SYS_CLOSE          3   /* (int fd) */
+#define SYS_READ           4   /* (int fd, void *buf, uint32_t size, uint32_t offset) */
+#define SYS_WRITE          5   /* (int fd, const void *buf, uint32_t size, uint32_t offset) */
+#define SYS_STAT           6   /* (const char *path, struct ipo_inode *out) */
+#define SYS_MALLOC         7   /* (uint32_t size) */
+#define SYS_FREE           8   /* (void *ptr) */
+#define SYS_GETPID         9   /* (void) */
+#define SYS_EXEC           10  /* (const char *path, int argc, char **argv) */
+#define SYS_STDIN_READ     11  /* (void *buf, uint32_t len) */
+#define SYS_TSC_KHZ        12  /* (void), 0 if the TSC is not calibrated */
+#define SYS_CREATE         13  /* (const char *path, uint8_t type) */
+#define SYS_DELETE         14  /* (const char *path) */
+#define SYS_COUNT          15
+
+#define SYSCALL_VECTOR     0x80
+
+/* Kernel stack pointer saved while a ring 3 process runs */
+typedef struct {
+    uint32_t kernel_esp;
+} user_context_t;
+
+/**
+ * Install the int 0x80 gate and, when supported, the SYSENTER MSRs
+ */
+void syscall_init(void);
+
+/**
+ * Set the kernel stack used for traps and SYSENTER from ring 3
+ */
+void syscall_set_kernel_stack(uint32_t esp0);
+
+/**
+ * Get the kernel stack currently used for traps from ring 3
+ */
+uint32_t syscall_get_kernel_stack(void);
+
+/**
+ * Check whether the SYSENTER fast path is available
+ */
+int syscall_has_sysenter(void);
+
+/* Called from the entry stubs */
+int32_t syscall_dispatch(uint32_t number, uint32_t arg1, uint32_t arg2, uint32_t arg3, uint32_t arg4);
+
+/* Implemented in lib/asm/syscall.asm */
+void syscall_int80_entry(void);
+void syscall_sysenter_entry(void);
+void user_exit_trampoline(void);
+
+/**
+ * Drop to ring 3 at entry with the given user stack.
+ * Returns the exit code once the process calls user_mode_leave().
+ */
+int user_mode_enter(uint32_t entry, uint32_t user_esp, user_context_t *ctx);
+
+/**
+ * Abandon the current ring 3 process and return exit_code from
+ * the matching user_mode_enter(). Does not return.
+ */
+void user_mode_leave(user_context_t *ctx, int exit_code) __attribute__((noreturn));
+
+#endif
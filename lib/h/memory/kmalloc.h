@@ -4,10 +4,23 @@
 #include <stddef.h>
 #include <stdint.h>
 
+typedef struct {
+    size_t bytes_in_use;   // Live allocations, headers included
+    size_t peak_bytes;     // High-water mark of bytes_in_use
+    uint32_t alloc_count;
+    uint32_t free_count;
+} kmalloc_stats_t;
+
 void* kmalloc(size_t size);
 
 void kfree(void* ptr);
 
 void kmalloc_init(void);
 
+void kmalloc_get_stats(kmalloc_stats_t *out);
+
+size_t kmalloc_reset_peak(void);
+
+void kmalloc_merge_peak(size_t peak);
+
 #endif // LIB_MEM_KMALLOC_H
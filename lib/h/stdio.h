@@ -15,27 +15,68 @@
 
 void putchar_color(char c, uint8_t fg, uint8_t bg);
 
+/**
+ * Write len characters to the console with the default colors,
+ * updating the hardware cursor once
+ */
+void console_write(const char *buf, size_t len);
+
+/**
+ * Write len characters to the console with specified colors
+ */
+void console_write_color(const char *buf, size_t len, uint8_t fg, uint8_t bg);
+
 /**
  * Low-level serial output (COM1)
  * @param c Character to output
  */
 void serial_putc(char c);
 
+/**
+ * Queue len characters for the serial port (COM1) without waiting for
+ * the line; see driver/serial.h
+ */
+void serial_write(const char *buf, size_t len);
+
 /**
  * Output a single character to VGA memory at cursor position
  * @param c Character to output
  */
 void putchar(char c);
 
+/**
+ * Destination of formatted output; write receives chunks of up to 128 bytes
+ */
+typedef struct format_sink {
+    void (*write)(struct format_sink *sink, const char *buf, size_t len);
+    void *ctx;
+} format_sink_t;
+
+/**
+ * Format engine shared by the printf family
+ * Supports: %d %i %u %x %X %o %p %c %s %%, the flags - 0 + space #,
+ * width and precision (numbers or *), and the ll length modifier
+ * @param sink Receives the output in chunks
+ * @param format Format string
+ * @param args Variable arguments
+ * @return Number of characters produced
+ */
+int vformat(format_sink_t *sink, const char *format, va_list args);
+
 /**
  * Formatted print function
- * Supports: %d (int), %u (unsigned), %x (hex), %c (char), %s (string), %%
+ * Supports the conversions of vformat()
  * @param format Format string
  * @param ... Variable arguments
  * @return Number of characters printed
  */
 int printf(const char *format, ...);
 
+/**
+ * Formatted print function, va_list version
+ */
+int vprintf(const char *format, va_list args);
+
 /**
  * Formatted print to buffer
  * @param buf Output buffer
@@ -46,6 +87,11 @@ int printf(const char *format, ...);
  */
 int snprintf(char *buf, size_t size, const char *format, ...);
 
+/**
+ * Formatted print to buffer, va_list version
+ */
+int vsnprintf(char *buf, size_t size, const char *format, va_list args);
+
 /**
  * Convert unsigned integer to string (internal use)
  */
@@ -58,11 +104,16 @@ int itoa64(uint64_t num, char *str, int base);
 
 /**
  * Formatted print to serial port
- * Supports: %d (int), %u (unsigned), %x (hex), %c (char), %s (string), %%
+ * Supports the conversions of vformat()
  * @param format Format string
  * @param ... Variable arguments
  * @return Number of characters printed
  */
 int serial_printf(const char *format, ...);
 
+/**
+ * Formatted print to serial port, va_list version
+ */
+int vserial_printf(const char *format, va_list args);
+
 #endif
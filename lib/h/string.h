@@ -18,6 +18,11 @@ void* memset(void *s, int c, size_t n);
  */
 void* memcpy(void *dest, const void *src, size_t n);
 
+/**
+ * Copy memory area, which may overlap
+ */
+void* memmove(void *dest, const void *src, size_t n);
+
 /**
  * Get string length
  */
@@ -0,0 +1,117 @@
+#ifndef _SYSCALL_H
+#define _SYSCALL_H
+
+/*
+ * Application side of the system call ABI (see kernel/syscall.h).
+ * Everything here is inline and position independent so that IPOB
+ * applications running in ring 3 never touch kernel code directly.
+ *
+ * Define IPO_SYSCALL_FAST before including this header to route the
+ * sys_* wrappers through SYSENTER instead of int 0x80. The kernel
+ * must report SYSENTER support (see syscall_has_sysenter()).
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <kernel/syscall.h>
+
+struct ipo_inode;
+
+static inline int32_t syscall_int80(uint32_t number, uint32_t arg1, uint32_t arg2, uint32_t arg3, uint32_t arg4) {
+    int32_t ret;
+    __asm__ volatile ("int $0x80"
+                      : "=a"(ret)
+                      : "a"(number), "b"(arg1), "c"(arg2), "d"(arg3), "S"(arg4)
+                      : "memory");
+    return ret;
+}
+
+static inline int32_t syscall_sysenter(uint32_t number, uint32_t arg1, uint32_t arg2, uint32_t arg3, uint32_t arg4) {
+    int32_t ret;
+    __asm__ volatile ("push %%ebp\n\t"
+                      "mov %%ecx, %%ebp\n\t"
+                      "mov %%esp, %%ecx\n\t"
+                      "call 1f\n"
+                      "1:\n\t"
+                      "pop %%edx\n\t"
+                      "add $(2f - 1b), %%edx\n\t"
+                      "sysenter\n"
+                      "2:\n\t"
+                      "pop %%ebp"
+                      : "=a"(ret), "+c"(arg4)
+                      : "a"(number), "b"(arg1), "S"(arg2), "D"(arg3)
+                      : "edx", "memory");
+    return ret;
+}
+
+#ifdef IPO_SYSCALL_FAST
+#define syscall4 syscall_sysenter
+#else
+#define syscall4 syscall_int80
+#endif
+
+static inline void sys_exit(int code) {
+    syscall4(SYS_EXIT, (uint32_t)code, 0, 0, 0);
+}
+
+static inline int sys_console_write(const char *buf, uint32_t len) {
+    return syscall4(SYS_CONSOLE_WRITE, (uint32_t)buf, len, 0, 0);
+}
+
+static inline int sys_print(const char *str) {
+    return sys_console_write(str, strlen(str));
+}
+
+static inline int sys_open(const char *path) {
+    return syscall4(SYS_OPEN, (uint32_t)path, 0, 0, 0);
+}
+
+static inline int sys_close(int fd) {
+    return syscall4(SYS_CLOSE, (uint32_t)fd, 0, 0, 0);
+}
+
+static inline int sys_read(int fd, void *buf, uint32_t size, uint32_t offset) {
+    return syscall4(SYS_READ, (uint32_t)fd, (uint32_t)buf, size, offset);
+}
+
+static inline int sys_write(int fd, const void *buf, uint32_t size, uint32_t offset) {
+    return syscall4(SYS_WRITE, (uint32_t)fd, (uint32_t)buf, size, offset);
+}
+
+static inline int sys_stat(const char *path, struct ipo_inode *out) {
+    return syscall4(SYS_STAT, (uint32_t)path, (uint32_t)out, 0, 0);
+}
+
+static inline void *sys_malloc(uint32_t size) {
+    return (void *)syscall4(SYS_MALLOC, size, 0, 0, 0);
+}
+
+static inline void sys_free(void *ptr) {
+    syscall4(SYS_FREE, (uint32_t)ptr, 0, 0, 0);
+}
+
+static inline int sys_getpid(void) {
+    return syscall4(SYS_GETPID, 0, 0, 0, 0);
+}
+
+static inline int sys_exec(const char *path, int argc, char **argv) {
+    return syscall4(SYS_EXEC, (uint32_t)path, (uint32_t)argc, (uint32_t)argv, 0);
+}
+
+static inline int sys_stdin_read(void *buf, uint32_t len) {
+    return syscall4(SYS_STDIN_READ, (uint32_t)buf, len, 0, 0);
+}
+
+static inline uint32_t sys_tsc_khz(void) {
+    return (uint32_t)syscall4(SYS_TSC_KHZ, 0, 0, 0, 0);
+}
+
+static inline int sys_create(const char *path, uint8_t type) {
+    return syscall4(SYS_CREATE, (uint32_t)path, type, 0, 0);
+}
+
+static inline int sys_delete(const char *path) {
+    return syscall4(SYS_DELETE, (uint32_t)path, 0, 0, 0);
+}
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef _CPU_H
+#define _CPU_H
+
+#include <stdint.h>
+
+/* Model specific registers */
+#define MSR_SYSENTER_CS   0x174
+#define MSR_SYSENTER_ESP  0x175
+#define MSR_SYSENTER_EIP  0x176
+
+/* CPUID leaf 1, EDX feature bits */
+#define CPUID_EDX_TSC     (1u << 4)
+#define CPUID_EDX_MSR     (1u << 5)
+#define CPUID_EDX_SEP     (1u << 11)
+#define CPUID_EDX_FXSR    (1u << 24)
+#define CPUID_EDX_SSE     (1u << 25)
+#define CPUID_EDX_SSE2    (1u << 26)
+
+/* Control register bits */
+#define CR0_MP            (1u << 1)
+#define CR0_EM            (1u << 2)
+#define CR0_TS            (1u << 3)
+#define CR4_OSFXSR        (1u << 9)
+#define CR4_OSXMMEXCPT    (1u << 10)
+
+/**
+ * Execute CPUID for the given leaf
+ * @param regs Output: eax, ebx, ecx, edx
+ */
+void cpu_cpuid(uint32_t leaf, uint32_t regs[4]);
+
+/**
+ * Write a model specific register
+ */
+void cpu_wrmsr(uint32_t msr, uint32_t low, uint32_t high);
+
+/**
+ * Read the time stamp counter
+ */
+uint64_t cpu_rdtsc(void);
+
+/**
+ * Read/write control registers CR0 and CR4
+ */
+uint32_t cpu_read_cr0(void);
+void cpu_write_cr0(uint32_t value);
+uint32_t cpu_read_cr4(void);
+void cpu_write_cr4(uint32_t value);
+
+/**
+ * Save/restore the x87 and SSE state to a 16-byte aligned 512-byte area
+ */
+void cpu_fxsave(void *area);
+void cpu_fxrstor(const void *area);
+
+/**
+ * Disable interrupts, returning the previous EFLAGS for cpu_irq_restore
+ */
+uint32_t cpu_irq_save(void);
+
+/**
+ * Restore the interrupt flag saved by cpu_irq_save
+ */
+void cpu_irq_restore(uint32_t flags);
+
+/**
+ * Enable interrupts
+ */
+void cpu_irq_enable(void);
+
+/**
+ * Check that all given CPUID leaf 1 EDX feature bits are set
+ */
+int cpu_has_feature_edx(uint32_t mask);
+
+#endif
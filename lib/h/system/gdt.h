@@ -0,0 +1,39 @@
+#ifndef _GDT_H
+#define _GDT_H
+
+#include <stdint.h>
+
+/* Segment selectors (index * 8). The order kernel code, kernel data,
+ * user code, user data is required by SYSENTER/SYSEXIT. */
+#define GDT_KERNEL_CODE  0x08
+#define GDT_KERNEL_DATA  0x10
+#define GDT_USER_CODE    0x18
+#define GDT_USER_DATA    0x20
+#define GDT_TSS          0x28
+
+/* Requested privilege level for ring 3 selectors */
+#define GDT_RPL_USER     0x03
+
+/**
+ * Install the kernel GDT (flat ring 0 / ring 3 segments and a TSS)
+ * and reload all segment registers.
+ */
+void gdt_init(void);
+
+/**
+ * Set the ring 0 stack used when a ring 3 task traps into the kernel
+ * @param esp0 Top of the kernel stack
+ */
+void tss_set_kernel_stack(uint32_t esp0);
+
+/**
+ * Get the ring 0 stack currently stored in the TSS
+ */
+uint32_t tss_get_kernel_stack(void);
+
+/* Implemented in lib/asm/descriptor.asm */
+void gdt_flush(const void *gdt_ptr);
+void tss_flush(uint16_t selector);
+void idt_flush(const void *idt_ptr);
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef _IDT_H
+#define _IDT_H
+
+#include <stdint.h>
+
+#define IDT_ENTRIES 256
+
+/* Gate type/attribute bytes */
+#define IDT_GATE_INTERRUPT      0x8E  /* present, ring 0, 32-bit interrupt gate */
+#define IDT_GATE_INTERRUPT_USER 0xEE  /* present, ring 3, 32-bit interrupt gate */
+
+/* Register state pushed by the common interrupt stub (lib/asm/interrupt.asm) */
+typedef struct {
+    uint32_t gs, fs, es, ds;
+    uint32_t edi, esi, ebp, esp, ebx, edx, ecx, eax;
+    uint32_t int_no, err_code;
+    uint32_t eip, cs, eflags;
+    uint32_t user_esp, user_ss;  /* only valid when coming from ring 3 */
+} interrupt_frame_t;
+
+typedef void (*interrupt_handler_t)(interrupt_frame_t *frame);
+
+/**
+ * Install the IDT with CPU exception handlers (vectors 0-31) and the
+ * remapped PIC IRQs (vectors 32-47, all masked until a driver enables one)
+ */
+void idt_init(void);
+
+/**
+ * Point a vector at a raw entry stub
+ * @param vector Interrupt vector
+ * @param handler Address of the assembly entry point
+ * @param flags Gate type/attribute byte (IDT_GATE_*)
+ */
+void idt_set_gate(uint8_t vector, uint32_t handler, uint8_t flags);
+
+/**
+ * Register a C handler for a vector routed through the common stub
+ */
+void idt_register_handler(uint8_t vector, interrupt_handler_t handler);
+
+/* Called from the common interrupt stub */
+void interrupt_dispatch(interrupt_frame_t *frame);
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef _PIC_H
+#define _PIC_H
+
+#include <stdint.h>
+
+/* 8259A PIC I/O ports */
+#define PIC1_COMMAND  0x20
+#define PIC1_DATA     0x21
+#define PIC2_COMMAND  0xA0
+#define PIC2_DATA     0xA1
+
+/* Vectors of IRQ 0-15 after remapping (0-31 belong to CPU exceptions) */
+#define PIC_IRQ_BASE  0x20
+#define PIC_IRQ_COUNT 16
+
+/* IRQ lines */
+#define IRQ_TIMER     0
+#define IRQ_KEYBOARD  1
+#define IRQ_CASCADE   2
+#define IRQ_COM2      3
+#define IRQ_COM1      4
+
+/**
+ * Remap the PICs to PIC_IRQ_BASE with every line masked
+ */
+void pic_init(void);
+
+/**
+ * Unmask an IRQ line
+ */
+void pic_enable_irq(uint8_t irq);
+
+/**
+ * Mask an IRQ line
+ */
+void pic_disable_irq(uint8_t irq);
+
+/**
+ * Acknowledge an IRQ; returns 0 for a spurious IRQ 7/15 that must not be handled
+ */
+int pic_ack_irq(uint8_t irq);
+
+#endif
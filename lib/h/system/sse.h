@@ -0,0 +1,47 @@
+#ifndef _SSE_H
+#define _SSE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* FXSAVE image size; the area must be 16-byte aligned */
+#define SSE_STATE_SIZE 512
+
+/* Room for one FXSAVE image at any alignment */
+typedef struct {
+    uint8_t area[SSE_STATE_SIZE + 15];
+} sse_state_t;
+
+/**
+ * Enable SSE (CR0.MP, CR4.OSFXSR/OSXMMEXCPT) when the CPU has FXSR and SSE2
+ * Returns true if SSE2 may be used from then on.
+ */
+bool sse_init(void);
+
+/**
+ * Check whether sse_init enabled SSE2
+ */
+bool sse_enabled(void);
+
+/**
+ * Let memcpy/memset stream large blocks with SSE2 (defined in string.c,
+ * so applications never link sse.c); sse_init turns it on
+ */
+void string_use_sse(bool enabled);
+
+/**
+ * Save the current x87/SSE register state (no-op without SSE)
+ */
+void sse_save(sse_state_t *state);
+
+/**
+ * Restore a state saved by sse_save (no-op without SSE)
+ */
+void sse_restore(const sse_state_t *state);
+
+/**
+ * Load the power-on x87/SSE state, for a process that starts fresh
+ */
+void sse_reset(void);
+
+#endif
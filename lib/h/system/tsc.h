@@ -0,0 +1,30 @@
+#ifndef _TSC_H
+#define _TSC_H
+
+#include <stdint.h>
+
+/* Length of the PIT gate used for calibration */
+#define TSC_CALIBRATE_MS 50
+
+/**
+ * Calibrate the TSC against PIT counter 2
+ * Leaves the frequency at 0 when the CPU has no TSC.
+ */
+void tsc_init(void);
+
+/**
+ * Read the TSC, or 0 when it is not available
+ */
+uint64_t tsc_read(void);
+
+/**
+ * Get the calibrated TSC frequency in kHz (0 if unknown)
+ */
+uint32_t tsc_get_khz(void);
+
+/**
+ * Convert a cycle count to microseconds (0 if uncalibrated)
+ */
+uint64_t tsc_cycles_to_us(uint64_t cycles);
+
+#endif
@@ -25,7 +25,11 @@ enum vga_color {
 
 #define VGA_WIDTH 80
 #define VGA_HEIGHT 25
-#define VGA_MEMORY ((volatile uint16_t*)0xB8000)
+#define VGA_TEXT_BASE ((volatile uint16_t*)0xB8000)
+#define VGA_TEXT_CELLS (32 * 1024 / 2)  // 32 KB of text memory
+
+// Top-left cell of the visible window (moves with hardware scrolling)
+#define VGA_MEMORY (vga_text_window())
 
 #define VGA_START_CURSOR_POSITION (VGA_WIDTH * 2)
 
@@ -34,8 +38,20 @@ static inline uint16_t vga_entry(unsigned char c, enum vga_color fg, enum vga_co
     return (uint16_t)c | ((bg << 4 | fg) << 8);
 }
 
+// Returns the first cell of the visible window
+volatile uint16_t *vga_text_window(void);
+
+// Returns the cell offset of the visible window in text memory
+uint16_t vga_get_window(void);
+
+// Pans the visible window to start at the given cell offset (CRTC start address)
+void vga_set_window(uint16_t start);
+
+// Copies the visible window to the start of text memory and shows it there
+void vga_reset_window(void);
+
 // Sets the cursor position
-// offset = row * VGA_WIDTH + col
+// offset = row * VGA_WIDTH + col, relative to the visible window
 void vga_set_cursor(uint16_t offset);
 
 // Shows the cursor
@@ -47,8 +63,12 @@ void vga_hide_cursor(void);
 // Clears the VGA screen with specified foreground and background colors and cursor settings
 void vga_clear(enum vga_color fg, enum vga_color bg, bool show_cursor, int cursor_position);
 
+// Returns the cursor position (kept in memory, no port I/O)
 uint16_t vga_get_cursor_position(void);
 
+// Re-reads the hardware cursor into the in-memory position
+void vga_resync_cursor(void);
+
 uint16_t vga_increment_cursor_position(void);
 
 uint16_t vga_decrement_cursor_position(void);
@@ -5,8 +5,17 @@ APPS_BUILD   := build/apps
 APPS_SRCS    := $(shell find $(APPS_DIR) -maxdepth 2 -name "*.c" -type f)
 APPS_BINS    := $(patsubst $(APPS_DIR)/%.c, $(APPS_BUILD)/%.bin, $(APPS_SRCS))
 
+# Applications run in ring 3 and use the syscall ABI (lib/h/syscall.h).
+# List an application here to run it in ring 0 with direct kernel access.
+APPS_RING0   :=
+
+# IPOB header flags: 0x1 = ring 3
+APPS_FLAGS    = $(if $(filter $(notdir $*),$(APPS_RING0)),0x0,0x1)
+
 # Compilation flags for applications (PIC for relocation independence)
+# Optimised like the library, but without LTO: apps link the fat objects' code
 APPS_CFLAGS := -m32 \
+	$(OPT_CFLAGS) \
 	-ffreestanding \
 	-fPIC \
 	-fno-builtin \
@@ -17,7 +26,7 @@ APPS_CFLAGS := -m32 \
 apps: $(APPS_BINS)
 
 # Rule: Compile .c to object file
-$(APPS_BUILD)/%.o: $(APPS_DIR)/%.c
+$(APPS_BUILD)/%.o: $(APPS_DIR)/%.c $(PROFILE_STAMP)
 	@mkdir -p $(dir $@)
 	$(CC) -c $< -o $@ -std=gnu11 $(APPS_CFLAGS)
 
@@ -31,11 +40,15 @@ $(APPS_BUILD)/%.bin: $(APPS_BUILD)/%.o $(LIB_A)
 	@$(CC) $(APPS_CFLAGS) -Wl,--entry=main \
 		$< $(LIB_A) -lgcc -o $@.elf -nostdlib -nostartfiles 2>&1 | grep -v "PIE\|relocation" || true
 	
+	@# Linked size, before the header is added
+	@$(SIZE) $@.elf | tail -n 1 | \
+		awk '{ printf "[size] %8s %6s %6s %8s  $*\n", $$1, $$2, $$3, $$4 }'
+	
 	@# Extract only program sections (not dynamic/debug)
 	@$(OBJCOPY) -j .text -j .rodata -j .data -O binary $@.elf $@.code
 	
-	@# Create IPO_BINARY header (20 bytes)
-	@python3 tools/gen_header.py $@.code $@.header
+	@# Create IPO_BINARY header (20 bytes); the entry offset comes from the ELF
+	@python3 tools/gen_header.py $@.code $@.header $(APPS_FLAGS) $@.elf
 	
 	@# Combine header + code
 	@cat $@.header $@.code > $@
@@ -0,0 +1,29 @@
+.PHONY: bench
+
+# Boots the current profile headless on a scratch disk holding the
+# benchmark apps, runs them from /autorun and powers off. Results are
+# the "bench|fsbench|fmtbench|ntbench ..." lines and membench's table in the
+# serial log; compare  make BUILD=debug bench  and  make BUILD=release bench
+BENCH_IMG     := $(BUILD_DIR)/bench.img
+BENCH_AUTORUN := $(BUILD_DIR)/bench.autorun
+BENCH_LOG     := $(BUILD_DIR)/bench-$(BUILD).log
+BENCH_APPS    := fsbench membench fmtbench
+BENCH_TIMEOUT := 600
+
+BENCH_QEMU_FLAGS := -drive format=raw,file=$(OS_IMAGE),if=ide,index=0 \
+                    -drive format=raw,file=$(BENCH_IMG),if=ide,index=1 \
+                    -display none -no-reboot \
+                    -serial file:$(BENCH_LOG)
+
+bench: $(OS_IMAGE) $(foreach app,$(BENCH_APPS),$(APPS_BUILD)/$(app)/$(app).bin)
+	@rm -f $(BENCH_IMG) $(BENCH_LOG)
+	@dd if=/dev/zero of=$(BENCH_IMG) bs=1M count=10 status=none
+	@python3 disk_editor.py -i $(BENCH_IMG) format
+	@for app in $(BENCH_APPS); do \
+		python3 disk_editor.py -i $(BENCH_IMG) put $(APPS_BUILD)/$$app/$$app.bin /app/$$app; \
+	done
+	@printf 'fsbench > /dev/serial\nmembench 4 > /dev/serial\nfmtbench > /dev/serial\nntbench 16 > /dev/serial\npoweroff\n' > $(BENCH_AUTORUN)
+	@python3 disk_editor.py -i $(BENCH_IMG) touch /autorun $(BENCH_AUTORUN)
+	@echo "[bench] $(BUILD) profile, log in $(BENCH_LOG)"
+	@timeout $(BENCH_TIMEOUT) $(QEMU) $(BENCH_QEMU_FLAGS) || true
+	@grep -E '^(bench|boottime|fsbench|fmtbench|ntbench) |^ +(size|[0-9]+) ' $(BENCH_LOG) || echo "[bench] no results, see $(BENCH_LOG)"
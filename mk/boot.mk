@@ -1,16 +1,35 @@
 .PHONY: boot
 boot: $(BOOT_BIN)
 
-$(BUILD)/boot/config.inc: $(SRC)/boot/config.inc.in $(KERNEL_BIN)
+# Sectors reserved for stage 2 right after the MBR
+STAGE2_SECTORS := 8
+
+STAGE1_BIN := $(BUILD_DIR)/boot/stage1.bin
+STAGE2_BIN := $(BUILD_DIR)/boot/stage2.bin
+
+$(BOOT_CFG_OUT): $(BOOT_CFG_IN) mk/boot.mk
+	@mkdir -p $(dir $@)
+	sed "s/@STAGE2_SECTORS@/$(STAGE2_SECTORS)/g" $< > $@
+
+# Kernel size and checksum (32-bit sum of the zero-padded sectors) for stage 2
+$(STAGE2_CFG_OUT): $(STAGE2_CFG_IN) $(KERNEL_BIN)
 	@mkdir -p $(dir $@)
 	@size=$$(stat -c %s $(KERNEL_BIN)); \
 	sectors=$$(( ($$size + 511) / 512 )); \
-	echo "KERNEL: $$size bytes -> $$sectors sectors"; \
-	sed "s/@KERNEL_SECTORS@/$$sectors/g" $< > $@
+	sum=$$(python3 tools/boot_checksum.py $(KERNEL_BIN)); \
+	echo "KERNEL: $$size bytes -> $$sectors sectors, checksum $$sum"; \
+	sed -e "s/@KERNEL_SECTORS@/$$sectors/g" -e "s/@KERNEL_CHECKSUM@/$$sum/g" $< > $@
 
-patch-config: $(KERNEL_BIN) $(BUILD)/boot/config.inc
+patch-config: $(KERNEL_BIN) $(BOOT_CFG_OUT) $(STAGE2_CFG_OUT)
 	@echo "Config updated"
 
-$(BOOT_BIN): src/boot/boot.asm $(KERNEL_BIN) $(BUILD)/boot/config.inc
+$(STAGE1_BIN): src/boot/stage1/stage1.asm $(BOOT_CFG_OUT)
 	mkdir -p $(dir $@)
-	nasm -f bin -I$(BUILD)/boot src/boot/boot.asm -o $@
+	$(ASM) $(ASM_BIN_FLAGS) $< -o $@
+
+$(STAGE2_BIN): src/boot/stage2/stage2.asm $(BOOT_CFG_OUT) $(STAGE2_CFG_OUT)
+	mkdir -p $(dir $@)
+	$(ASM) $(ASM_BIN_FLAGS) $< -o $@
+
+$(BOOT_BIN): $(STAGE1_BIN) $(STAGE2_BIN)
+	cat $^ > $@
@@ -1,4 +1,4 @@
 clean:
-	rm -rf $(BUILD)
+	rm -rf $(BUILD_DIR)
 
 .PHONY: clean
@@ -7,26 +7,48 @@ CC      := gcc
 LD      := ld
 AR      := ar
 OBJCOPY := objcopy
+SIZE    := size
 QEMU    := qemu-system-i386
 
 
+# ==================================================
+#                  BUILD PROFILE
+# ==================================================
+
+# make BUILD=release for an optimised build; switching rebuilds everything
+BUILD ?= debug
+
+ifeq ($(BUILD),release)
+# i686 keeps the compiler away from SSE, which is only usable after sse_init.
+# Loop distribution would turn the loops inside memset/memcpy into calls to them.
+OPT_CFLAGS := -O2 -fomit-frame-pointer -march=i686 -fno-tree-loop-distribute-patterns
+LTO_CFLAGS := -flto -ffat-lto-objects
+AR         := gcc-ar
+else ifeq ($(BUILD),debug)
+OPT_CFLAGS := -O0 -g
+LTO_CFLAGS :=
+else
+$(error BUILD must be debug or release, not '$(BUILD)')
+endif
+
+
 # ==================================================
 #                 PROJECT DIRECTORIES
 # ==================================================
 
 SRC     := src
-BUILD   := build
+BUILD_DIR := build
 
 
 # ==================================================
 #                 OUTPUT / ARTIFACTS
 # ==================================================
 
-BOOT_BIN   := $(BUILD)/boot/boot.bin
+BOOT_BIN   := $(BUILD_DIR)/boot/boot.bin
 
-KERNEL_ELF := $(BUILD)/kernel/kernel.elf
-KERNEL_BIN := $(BUILD)/kernel/kernel.bin
-OS_IMAGE   := $(BUILD)/IPO_OS.img
+KERNEL_ELF := $(BUILD_DIR)/kernel/kernel.elf
+KERNEL_BIN := $(BUILD_DIR)/kernel/kernel.bin
+OS_IMAGE   := $(BUILD_DIR)/IPO_OS.img
 
 
 # ==================================================
@@ -34,7 +56,7 @@ OS_IMAGE   := $(BUILD)/IPO_OS.img
 # ==================================================
 
 LIB_DIR       := lib
-LIB_BUILD_DIR := $(BUILD)/lib
+LIB_BUILD_DIR := $(BUILD_DIR)/lib
 LIB_A         := $(LIB_BUILD_DIR)/libc.a
 
 
@@ -43,12 +65,10 @@ LIB_A         := $(LIB_BUILD_DIR)/libc.a
 # ==================================================
 
 BOOT_CFG_IN    := $(SRC)/boot/config.inc.in
-STAGE1_CFG_IN  := $(SRC)/boot/stage1/config.inc.in
 STAGE2_CFG_IN  := $(SRC)/boot/stage2/config.inc.in
 
-BOOT_CFG_OUT   := $(BUILD)/boot/config.inc
-STAGE1_CFG_OUT := $(BUILD)/boot/stage1/config.inc
-STAGE2_CFG_OUT := $(BUILD)/boot/stage2/config.inc
+BOOT_CFG_OUT   := $(BUILD_DIR)/boot/config.inc
+STAGE2_CFG_OUT := $(BUILD_DIR)/boot/stage2/config.inc
 
 
 # ==================================================
@@ -87,21 +107,40 @@ ASM_BIN_FLAGS := -f bin \
 	-I$(SRC)/boot \
 	-I$(SRC)/boot/stage1 \
 	-I$(SRC)/boot/stage2 \
-	-I$(BUILD)/boot \
-	-I$(BUILD)/boot/stage1 \
-	-I$(BUILD)/boot/stage2
+	-I$(BUILD_DIR)/boot \
+	-I$(BUILD_DIR)/boot/stage1 \
+	-I$(BUILD_DIR)/boot/stage2
 
 ASM_ELF_FLAGS := -f elf32
 
+# Most verbose log level compiled into the kernel (0 none ... 5 trace)
+LOG_LEVEL ?= 4
+
 LIB_CFLAGS := -m32 \
+	$(OPT_CFLAGS) $(LTO_CFLAGS) \
 	-ffreestanding \
 	-fno-pic -fno-pie \
 	-fno-builtin \
 	-nostdlib -nostartfiles \
+	-DLOG_COMPILE_LEVEL=$(LOG_LEVEL) \
 	-Ilib/h
 
 LD_FLAGS := -T $(SRC)/kernel/linker.ld -nostdlib
 
+# LTO needs the compiler driver to run the linker plugin
+ifeq ($(BUILD),release)
+KERNEL_LINK := $(CC) -m32 $(OPT_CFLAGS) $(LTO_CFLAGS) -no-pie -Wl,--build-id=none -Wl,--oformat,elf32-i386
+else
+KERNEL_LINK := $(LD) -m elf_i386 --oformat elf32-i386
+endif
+
+# Per-object text/data/bss/dec of $(1), largest first
+SIZE_TABLE = $(SIZE) $(1) | tail -n +2 | sort -k4 -n -r | \
+	awk '{ printf "%8s %6s %6s %8s  %s\n", $$1, $$2, $$3, $$4, $$6 }'
+
+# Recreated on every profile or log level switch, so all objects depending on it rebuild
+PROFILE_STAMP := $(BUILD_DIR)/.profile-$(BUILD)-log$(LOG_LEVEL)
+
 QEMU_FLAGS := -drive format=raw,file=$(OS_IMAGE),if=ide,index=0 \
               -drive format=raw,file=build/disk.img,if=ide,index=1 \
               -cdrom build/disk.iso \
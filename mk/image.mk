@@ -1,8 +1,10 @@
 .PHONY: image
 image: $(OS_IMAGE) disks
 
+# The kernel is padded to whole sectors to match the checksum stage 2 verifies
 $(OS_IMAGE): $(BOOT_BIN) $(KERNEL_BIN)
 	cat $^ > $@
+	truncate -s %512 $@
 
 # Create a 10MB IMG disk (raw format)
 build/disk.img:
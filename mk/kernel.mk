@@ -1,14 +1,31 @@
-.PHONY: kernel
+.PHONY: kernel size-report
 kernel: $(KERNEL_BIN)
 
-$(BUILD)/kernel/entry32.o: src/kernel/entry32.asm
+$(PROFILE_STAMP):
+	@mkdir -p $(dir $@)
+	@rm -f $(BUILD_DIR)/.profile-*
+	@touch $@
+
+$(BUILD_DIR)/kernel/entry32.o: src/kernel/entry32.asm $(PROFILE_STAMP)
 	mkdir -p $(dir $@)
 	$(ASM) $(ASM_ELF_FLAGS) $< -o $@
 
-$(BUILD)/kernel/kernel32.o: src/kernel/kernel32.c
+$(BUILD_DIR)/kernel/kernel32.o: src/kernel/kernel32.c $(PROFILE_STAMP)
 	mkdir -p $(dir $@)
-	gcc -m32 -ffreestanding -fno-pic -fno-pie -fno-builtin -nostdlib -nostartfiles -Ilib/h -c $< -o $@
+	$(CC) -c $< -o $@ -std=gnu11 $(LIB_CFLAGS)
+
+KERNEL_OBJS := $(BUILD_DIR)/kernel/entry32.o $(BUILD_DIR)/kernel/kernel32.o $(LIB_OBJS)
+
+$(KERNEL_BIN): $(KERNEL_OBJS)
+	$(KERNEL_LINK) $(LD_FLAGS) -o $(KERNEL_ELF) $^ $(LIBGCC)
+	$(OBJCOPY) -O binary $(KERNEL_ELF) $@
+	@$(MAKE) --no-print-directory size-report
 
-$(KERNEL_BIN): $(BUILD)/kernel/entry32.o $(BUILD)/kernel/kernel32.o $(LIB_OBJS)
-	ld -m elf_i386 -T src/kernel/linker.ld -nostdlib --oformat elf32-i386 -o $(KERNEL_ELF) $^ $(LIBGCC)
-	$(OBJCOPY) -O binary $(KERNEL_ELF) $@
\ No newline at end of file
+# Per-object code/data sizes, largest first, then the linked kernel.
+# Release objects are fat LTO objects: the sizes are before link-time inlining.
+size-report:
+	@echo "[size] $(BUILD) profile: text data bss dec per object"
+	@$(call SIZE_TABLE,$(KERNEL_OBJS))
+	@$(SIZE) $(KERNEL_ELF) | tail -n 1 | \
+		awk '{ printf "%8s %6s %6s %8s  kernel.elf\n", $$1, $$2, $$3, $$4 }'
+	@echo "[size] kernel.bin: $$(stat -c %s $(KERNEL_BIN)) bytes"
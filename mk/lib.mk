@@ -4,6 +4,10 @@ lib: $(LIB_A)
 $(LIB_A): $(LIB_OBJS)
 	@mkdir -p $(dir $@)
 	$(AR) rcs $@ $^
+	@echo "[size] $(BUILD) profile: text data bss dec per library object"
+	@$(call SIZE_TABLE,$^)
+
+$(LIB_OBJS): $(PROFILE_STAMP)
 
 # C sources
 $(LIB_BUILD_DIR)/%.o: $(LIB_DIR)/%.c
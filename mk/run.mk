@@ -1,2 +1,9 @@
 run:
 	$(QEMU) $(QEMU_FLAGS) -serial stdio
+
+# Boots kernel.elf through QEMU's Multiboot loader, skipping the boot sectors.
+# The same drives are attached, so the file system stays on the second disk.
+KERNEL_CMDLINE ?=
+
+run-fast: $(KERNEL_BIN) $(OS_IMAGE) disks
+	$(QEMU) $(QEMU_FLAGS) -kernel $(KERNEL_ELF) -append "$(KERNEL_CMDLINE)" -serial stdio
@@ -1,15 +1,32 @@
 %include "config.inc"
 
+; Stage 1: MBR. Loads stage 2 from the sectors right after it and jumps to it.
+
 BITS 16
 ORG 0x7C00
 
+STAGE2_ADDR equ 0x7E00
+
 start:
+    ; setup segments + stack
+    cli
+    xor ax, ax
+    mov ds, ax
+    mov es, ax
+    mov ss, ax
+    mov sp, 0x7C00
+    sti
+    jmp 0x0000:.flat_cs
+.flat_cs:
+
+    mov [BOOT_DRIVE], dl
+
     mov si, msg
     call print
-    
+
     mov si, tab
     call print
-    
+
     mov si, tab
     call print
 
@@ -18,19 +35,10 @@ start:
 
     mov si, new_line
     call print
-    
+
     mov si, new_line
     call print
 
-    ; setup segments + stack
-    xor ax, ax
-    mov ds, ax
-    mov es, ax
-    mov ss, ax
-    mov sp, 0x7C00
-
-    mov [BOOT_DRIVE], dl
-
     ; progress: A
     mov ax, 0x0E41
     int 0x10
@@ -44,7 +52,7 @@ start:
     cmp bx, 0xAA55
     jne disk_error
 
-    ; DAP-based LBA read: read KERNEL_SECTORS from LBA 1 to 0x10000
+    ; DAP-based LBA read: read STAGE2_SECTORS from STAGE2_LBA to 0x7E00
     mov si, dap
     mov dl, [BOOT_DRIVE]
     mov ah, 0x42
@@ -55,59 +63,9 @@ start:
     mov ax, 0x0E52
     int 0x10
 
-    ; enable A20
-    in al, 0x92
-    or al, 00000010b
-    out 0x92, al
-
-    cli
-    jmp short pm_setup       ; >>> skip over GDT data <<<
-
-align 8
-gdt_start:
-    dq 0x0000000000000000
-    dq 0x00CF9A000000FFFF   ; code, base=0, limit=4GB
-    dq 0x00CF92000000FFFF   ; data, base=0, limit=4GB
-gdt_end:
-
-gdt_desc:
-    dw gdt_end - gdt_start - 1
-    dd gdt_start
-
-pm_setup:
-    ; progress: G
-    mov ax, 0x0E47
-    int 0x10
-
-    ; --- hide BIOS text cursor while still in real mode ---
-    mov ah, 0x01
-    mov ch, 0x20     ; bit 5 set to hide
-    mov cl, 0x00
-    int 0x10
-
-    ; NOTE: BIOS ints no longer work fully after the code below.
-    lgdt [gdt_desc]
-    mov eax, cr0
-    or  eax, 1
-    mov cr0, eax
-
-    ; NOTE: after this far jump, BIOS ints no longer work at all.
-    jmp 0x08:pmode_entry
-
-[BITS 32]
-pmode_entry:
-    mov ax, 0x10
-    mov ds, ax
-    mov es, ax
-    mov ss, ax
-    mov fs, ax
-    mov gs, ax
-    mov esp, 0x90000
-
-    ; Jump to kernel at linear 0x00010000
-    jmp 0x00010000
+    mov dl, [BOOT_DRIVE]
+    jmp 0x0000:STAGE2_ADDR
 
-[BITS 16]
 disk_error:
     mov ax, 0x0E45          ; 'E'
     int 0x10
@@ -116,14 +74,14 @@ disk_error:
 
 BOOT_DRIVE: db 0
 
-; DAP: read KERNEL_SECTORS from LBA=1 into 0x10000
+; DAP: read STAGE2_SECTORS from STAGE2_LBA into 0x0000:7E00
 dap:
     db 16
     db 0
-    dw KERNEL_SECTORS
-    dw 0x0000               ; offset
-    dw 0x1000               ; segment 0x1000:0000 = phys 0x10000
-    dd 1                    ; LBA start
+    dw STAGE2_SECTORS
+    dw STAGE2_ADDR          ; offset
+    dw 0x0000               ; segment
+    dd STAGE2_LBA           ; LBA start
     dd 0
 
 ; ============================================================
@@ -148,4 +106,4 @@ tab         db "  ", 0
 new_line    db 13, 10, 0
 
 times 510-($-$$) db 0
-dw 0xAA55
\ No newline at end of file
+dw 0xAA55
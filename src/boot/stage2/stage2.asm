@@ -0,0 +1,226 @@
+%include "config.inc"
+%include "stage2/config.inc"
+
+; Stage 2: loads the kernel to 1 MB and enters protected mode.
+;
+; INT 13h can only write below 1 MB and a single DAP transfer is capped at
+; 127 sectors, so the kernel is read in CHUNK_SECTORS pieces into a low
+; bounce buffer and copied up through unreal mode (4 GB DS/ES limits).
+
+BITS 16
+ORG 0x7E00
+
+KERNEL_LOAD_ADDR equ 0x00100000
+KERNEL_MAX_SIZE  equ 0x00F00000     ; kmalloc heap starts at 16 MB
+BOUNCE_SEG       equ 0x1000         ; 0x1000:0000 = phys 0x10000
+BOUNCE_ADDR      equ 0x00010000
+CHUNK_SECTORS    equ 64             ; 32 KB per INT 13h call
+
+%if KERNEL_SECTORS * 512 > KERNEL_MAX_SIZE
+    %error "kernel does not fit between 1 MB and the kernel heap"
+%endif
+
+stage2_start:
+    xor ax, ax
+    mov ds, ax
+    mov es, ax
+    mov [boot_drive], dl
+
+    mov si, msg_loading
+    call print
+
+    call enable_a20
+
+    mov dword [lba], KERNEL_LBA
+    mov dword [dest], KERNEL_LOAD_ADDR
+    mov word [remaining], KERNEL_SECTORS
+    mov dword [checksum], 0
+
+.next_chunk:
+    mov cx, [remaining]
+    test cx, cx
+    jz .loaded
+    cmp cx, CHUNK_SECTORS
+    jbe .read
+    mov cx, CHUNK_SECTORS
+.read:
+    mov [chunk], cx
+    mov [dap_count], cx
+    mov eax, [lba]
+    mov [dap_lba], eax
+
+    mov si, dap
+    mov dl, [boot_drive]
+    mov ah, 0x42
+    int 0x13
+    jc disk_error
+
+    ; the BIOS may have reloaded the segment limits, so set them every time
+    call enter_unreal
+
+    ; copy the chunk above 1 MB, summing it as we go
+    movzx ecx, word [chunk]
+    shl ecx, 7                      ; dwords
+    mov esi, BOUNCE_ADDR
+    mov edi, [dest]
+    mov ebx, [checksum]
+.copy:
+    mov eax, [esi]
+    add ebx, eax
+    mov [edi], eax
+    add esi, 4
+    add edi, 4
+    dec ecx
+    jnz .copy
+    mov [checksum], ebx
+    mov [dest], edi
+
+    movzx eax, word [chunk]
+    add [lba], eax
+    sub [remaining], ax
+
+    ; progress: one dot per chunk
+    mov ax, 0x0E2E
+    int 0x10
+    jmp .next_chunk
+
+.loaded:
+    cmp dword [checksum], KERNEL_CHECKSUM
+    jne checksum_error
+
+    mov si, msg_ok
+    call print
+
+    ; --- hide BIOS text cursor while still in real mode ---
+    mov ah, 0x01
+    mov ch, 0x20     ; bit 5 set to hide
+    mov cl, 0x00
+    int 0x10
+
+    ; NOTE: BIOS ints no longer work fully after the code below.
+    cli
+    lgdt [gdt_desc]
+    mov eax, cr0
+    or  eax, 1
+    mov cr0, eax
+
+    ; NOTE: after this far jump, BIOS ints no longer work at all.
+    jmp 0x08:pmode_entry
+
+[BITS 32]
+pmode_entry:
+    mov ax, 0x10
+    mov ds, ax
+    mov es, ax
+    mov ss, ax
+    mov fs, ax
+    mov gs, ax
+    mov esp, 0x90000
+
+    ; Jump to kernel at linear 0x00100000
+    jmp KERNEL_LOAD_ADDR
+
+[BITS 16]
+; ============================================================
+; enable_a20 - BIOS first, then the fast A20 gate
+; ============================================================
+enable_a20:
+    mov ax, 0x2401
+    int 0x15
+    in al, 0x92
+    test al, 00000010b
+    jnz .done
+    or al, 00000010b
+    and al, 11111110b       ; never pulse the reset bit
+    out 0x92, al
+.done:
+    ret
+
+; ============================================================
+; enter_unreal - give DS/ES 4 GB limits and return to real mode
+; ============================================================
+enter_unreal:
+    cli
+    push ds
+    push es
+    lgdt [gdt_desc]
+    mov eax, cr0
+    or al, 1
+    mov cr0, eax
+    jmp short .pmode
+.pmode:
+    mov bx, 0x10
+    mov ds, bx
+    mov es, bx
+    and al, 0xFE
+    mov cr0, eax
+    pop es
+    pop ds
+    sti
+    ret
+
+disk_error:
+    mov si, msg_disk_error
+    jmp fail
+
+checksum_error:
+    mov si, msg_checksum_error
+
+fail:
+    call print
+.hang:  hlt
+        jmp .hang
+
+; ============================================================
+; Print
+; ============================================================
+print:
+    pusha
+.print_loop:
+    lodsb
+    test al, al
+    jz .done
+    mov ah, 0x0E
+    int 0x10
+    jmp .print_loop
+.done:
+    popa
+    ret
+
+align 8
+gdt_start:
+    dq 0x0000000000000000
+    dq 0x00CF9A000000FFFF   ; code, base=0, limit=4GB
+    dq 0x00CF92000000FFFF   ; data, base=0, limit=4GB
+gdt_end:
+
+gdt_desc:
+    dw gdt_end - gdt_start - 1
+    dd gdt_start
+
+align 4
+; DAP: read [dap_count] sectors from [dap_lba] into the bounce buffer
+dap:
+    db 16
+    db 0
+dap_count:
+    dw 0
+    dw 0x0000               ; offset
+    dw BOUNCE_SEG           ; segment
+dap_lba:
+    dd 0
+    dd 0
+
+lba         dd 0
+dest        dd 0
+checksum    dd 0
+remaining   dw 0
+chunk       dw 0
+boot_drive  db 0
+
+msg_loading         db "Loading kernel ", 0
+msg_ok              db " OK", 13, 10, 0
+msg_disk_error      db 13, 10, "Disk read error", 0
+msg_checksum_error  db 13, 10, "Kernel checksum mismatch", 0
+
+times STAGE2_SECTORS*512-($-$$) db 0
@@ -1,10 +1,40 @@
 BITS 32
 global _start
 extern kmain
+extern __bss_start, __bss_end
+
+MB_MAGIC    equ 0x1BADB002
+MB_FLAGS    equ 0x00000003          ; page-aligned modules, memory info
+MB_CHECKSUM equ -(MB_MAGIC + MB_FLAGS)
+
+; Linked first (see linker.ld): stage 2 jumps to the first byte of the
+; kernel, Multiboot loaders find the header in the first 8 KB.
+section .entry progbits alloc exec nowrite align=4
 
 _start:
+    jmp multiboot_entry
+
+align 4
+multiboot_header:
+    dd MB_MAGIC
+    dd MB_FLAGS
+    dd MB_CHECKSUM
+
+; EAX = Multiboot magic, EBX = info address; anything else from stage 2
+multiboot_entry:
+    cli
+    cld
     mov esp, 0x90000
     mov dword [0xB8000], 0x07204B    ; 'K' at top-left
+    push ebx
+    push eax
+    ; stage 2 loads only kernel.bin, so .bss holds whatever was in memory
+    mov edi, __bss_start
+    mov ecx, __bss_end
+    sub ecx, edi
+    shr ecx, 2
+    xor eax, eax
+    rep stosd
     call kmain
 .hang:  hlt
-        jmp .hang
\ No newline at end of file
+        jmp .hang
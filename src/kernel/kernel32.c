@@ -1,11 +1,21 @@
 #include <kernel/terminal.h>
 #include <kernel/autorun.h>
+#include <kernel/boot_info.h>
+#include <kernel/boot_timeline.h>
+#include <kernel/log.h>
 #include <vga.h>
 #include <ioport.h>
 #include <driver/sound.h>
 #include <driver/ata/ata.h>
+#include <driver/serial.h>
 #include <file_system/ipo_fs.h>
 #include <kernel/process.h>
+#include <kernel/syscall.h>
+#include <system/gdt.h>
+#include <system/idt.h>
+#include <system/cpu.h>
+#include <system/sse.h>
+#include <system/tsc.h>
 #include <stdio.h>
 
 #define FS_START_LBA (uint32_t)2048
@@ -15,7 +25,7 @@ static void ensure_fs_mounted(void) {
         printf("Mounted IPO_FS at LBA %u\n", FS_START_LBA);
     } else {
         printf("No IPO_FS at LBA %u, formatting...\n", FS_START_LBA);
-        if (!ipo_fs_format(FS_START_LBA, 10000, 1024)) {
+        if (!ipo_fs_format(FS_START_LBA, 10000, 1024, IPO_FS_DEFAULT_BLOCK_SIZE)) {
             printf("ipo_fs_format failed\n");
         } else if (!ipo_fs_mount(FS_START_LBA)) {
             printf("ipo_fs_mount failed after format\n");
@@ -58,24 +68,68 @@ void play_startup_sound(void) {
 }
 
 
-void kmain(void) {
-    terminal_initialize();
+/*
+ * Applies loglevel=<level> from the kernel command line to every subsystem,
+ * then logs how the kernel was booted at the new level
+ */
+static void apply_cmdline(void) {
+    char value[16];
+    if (boot_cmdline_value("loglevel", value, sizeof(value))) {
+        int level = log_parse_level(value);
+        if (level < 0) {
+            printf("Ignoring bad loglevel=%s\n", value);
+        } else {
+            for (int i = 0; i < LOG_SUBSYSTEM_COUNT; i++) log_set_level(i, level);
+        }
+    }
+    LOG_INFO(LOG_KERNEL, "booted by %s, cmdline '%s'\n",
+             boot_info_get()->loader, boot_info_get()->cmdline);
+}
+
+/* Runs one init step and closes its boot timeline stage */
+#define BOOT_STAGE(name, call) \
+    do { \
+        call; \
+        boot_timeline_mark(name); \
+    } while (0)
+
+void kmain(uint32_t boot_magic, uint32_t boot_info_addr) {
+    boot_timeline_start();
+
+    BOOT_STAGE("boot_info", boot_info_init(boot_magic, boot_info_addr));
+
+    BOOT_STAGE("gdt", gdt_init());
+
+    BOOT_STAGE("idt", idt_init());
+
+    BOOT_STAGE("terminal", terminal_initialize());
     
-    process_init();
+    BOOT_STAGE("serial", serial_init());
+    cpu_irq_enable();
+
+    BOOT_STAGE("cmdline", apply_cmdline());
+
+    BOOT_STAGE("sse", sse_init());
+
+    BOOT_STAGE("process", process_init());
+
+    BOOT_STAGE("syscall", syscall_init());
 
-    sound_init();
+    BOOT_STAGE("sound", sound_init());
     
-    ata_init();
+    BOOT_STAGE("ata", ata_init());
 
-    ipo_fs_init();
+    BOOT_STAGE("tsc", tsc_init());
 
-    ensure_fs_mounted();
+    BOOT_STAGE("fs_init", ipo_fs_init());
 
-    process_init();
+    BOOT_STAGE("fs_mount", ensure_fs_mounted());
 
-    play_startup_sound();
+    BOOT_STAGE("startup_sound", play_startup_sound());
 
-    terminal_initialize();
+    // Machine-readable for `make bench`; the TSC counts from reset, firmware included
+    serial_printf("bench boot_ms %u\n", (uint32_t)(tsc_cycles_to_us(tsc_read()) / 1000));
+    boot_timeline_dump_serial();
 
     autorun_init();
 
@@ -0,0 +1,10 @@
+#!/usr/bin/env python3
+# Usage: boot_checksum.py <kernel.bin>
+# Prints the checksum stage 2 verifies after loading the kernel: the image
+# zero-padded to whole sectors, summed as little-endian dwords mod 2^32.
+import sys, struct
+
+data = open(sys.argv[1], 'rb').read()
+data += b'\0' * (-len(data) % 512)
+words = struct.unpack('<%dI' % (len(data) // 4), data)
+print('0x%08X' % (sum(words) & 0xFFFFFFFF))
@@ -1,6 +1,28 @@
 #!/usr/bin/env python3
+# Usage: gen_header.py <code.bin> <header.out> [flags] [app.elf]
+# With the ELF, entry_offset points at its entry symbol inside the code;
+# without it the code is assumed to start with main().
 import sys, struct
+
+EXTRACTED = (b'.text', b'.rodata', b'.data')
+
+def entry_offset(elf_path):
+    elf = open(elf_path, 'rb').read()
+    entry = struct.unpack_from('<I', elf, 24)[0]
+    shoff = struct.unpack_from('<I', elf, 32)[0]
+    shentsize, shnum, shstrndx = struct.unpack_from('<HHH', elf, 46)
+    sections = [struct.unpack_from('<IIIIIIIIII', elf, shoff + i * shentsize) for i in range(shnum)]
+    strtab = sections[shstrndx][4]
+    def name(sh):
+        start = strtab + sh[0]
+        return elf[start:elf.index(b'\0', start)]
+    # objcopy -O binary starts the image at the lowest extracted section
+    base = min(sh[3] for sh in sections if name(sh) in EXTRACTED and sh[5] > 0)
+    return entry - base
+
 code_size = len(open(sys.argv[1], 'rb').read())
 total = code_size + 20
-h = b'IPO_B' + b'\x00\x00\x00' + struct.pack('<II I', 20, total, 0)
+flags = int(sys.argv[3], 0) if len(sys.argv) > 3 else 0
+entry = 20 + (entry_offset(sys.argv[4]) if len(sys.argv) > 4 else 0)
+h = b'IPO_B' + b'\x00\x00\x00' + struct.pack('<II I', entry, total, flags)
 open(sys.argv[2], 'wb').write(h)